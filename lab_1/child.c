@@ -1,97 +1,247 @@
+#define _GNU_SOURCE
+
 #include <stdint.h>
 #include <stdbool.h>
 #include <ctype.h>
 
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 #include <stdio.h>
 #include <math.h>
 
-int main(int argc, char **argv) {
-	char buf[4096];
-	ssize_t bytes;
+// NOTE: Results of one batch of lines are collected in one of two buffers and sent with one
+//       call. `vmsplice` puts the pages of the buffer into the pipe instead of copying them, so
+//       a buffer must not be written while the pipe still holds its pages; meanwhile the other is used
+static char out_bufs[2][65536] __attribute__((aligned(4096)));
+static int out_cur;
+static char *out_buf = out_bufs[0];
+static size_t out_len;
+static bool use_vmsplice = true;
 
-	// NOTE: `O_WRONLY` only enables file for writing
-	// NOTE: `O_CREAT` creates the requested file if absent
-	// NOTE: `O_TRUNC` empties the file prior to opening
-	// NOTE: `O_APPEND` subsequent writes are being appended instead of overwritten
-	int32_t file = open(argv[1], O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0600);
-	if (file == -1) {
-		const char msg[] = "ERROR: Failed to open requested file\n";
-		write(STDOUT_FILENO, msg, sizeof(msg) - 1);
-		_exit(EXIT_FAILURE);
+static bool write_all(int fd, const char *data, size_t len) {
+	while (len > 0) {
+		ssize_t written = write(fd, data, len);
+		if (written <= 0) {
+			return false;
+		}
+		data += written;
+		len -= written;
+	}
+	return true;
+}
+
+// NOTE: STDOUT is a pipe when started by `parent`; otherwise `vmsplice` fails and plain
+//       `write` is used from then on
+static bool send_output(const char *data, size_t len) {
+	while (use_vmsplice && len > 0) {
+		struct iovec iov = {(void *)data, len};
+		ssize_t moved = vmsplice(STDOUT_FILENO, &iov, 1, 0);
+		if (moved < 0) {
+			if (errno != EBADF && errno != EINVAL) {
+				return false;
+			}
+			use_vmsplice = false;
+			break;
+		}
+		data += moved;
+		len -= moved;
+	}
+	return write_all(STDOUT_FILENO, data, len);
+}
+
+// NOTE: Results go both to the file and to the parent, error lines only to the parent,
+//       which needs them in input order to report them. A worker has no file (`file == -1`):
+//       its parent puts the results of all workers in order and writes the file itself.
+static bool flush_output(int file) {
+	const char error_prefix[] = "ERROR: ";
+	const char *run = out_buf;
+	const char *ptr = out_buf;
+	const char *end = out_buf + out_len;
+	bool ok = true;
+	while (file != -1 && ptr <= end) {
+		const char *next = ptr < end ? (const char *)memchr(ptr, '\n', end - ptr) + 1 : end + 1;
+		bool error = ptr < end && strncmp(ptr, error_prefix, sizeof(error_prefix) - 1) == 0;
+		if ((error || ptr == end) && ok && !write_all(file, run, ptr - run)) {
+			const char msg[] = "ERROR: Failed to write to file\n";
+			write(STDOUT_FILENO, msg, sizeof(msg) - 1);
+			ok = false;
+		}
+		if (error) {
+			run = next;
+		}
+		ptr = next;
+	}
+
+	if (!send_output(out_buf, out_len)) {
+		ok = false;
 	}
 
-	// NOTE: Read input data from standard input into the buffer
-	bytes = read(STDIN_FILENO, buf, sizeof(buf) - 1);
-	if (bytes < 0) {
-		const char msg[] = "ERROR: Failed to read from stdin\n";
+	// NOTE: The other buffer was sent by the previous flush; it has been read once the pipe
+	//       holds no more than what was just sent. Otherwise the parent is behind, and instead of
+	//       waiting for it the buffer gets fresh pages: `MAP_FIXED` maps new zero pages at the same
+	//       address, while the pipe keeps the old ones until the parent reads them
+	size_t sent = out_len;
+	out_cur ^= 1;
+	out_buf = out_bufs[out_cur];
+	out_len = 0;
+	int queued;
+	if (use_vmsplice && (ioctl(STDOUT_FILENO, FIONREAD, &queued) != 0 || (size_t)queued > sent)
+		&& mmap(out_buf, sizeof(out_bufs[0]), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1,
+				0) == MAP_FAILED) {
+		const char msg[] = "ERROR: Failed to replace output buffer\n";
 		write(STDOUT_FILENO, msg, sizeof(msg) - 1);
-		exit(EXIT_FAILURE);
+		ok = false;
 	}
+	return ok;
+}
 
-	buf[bytes] = '\0';
+static bool emit(int file, const char *line, size_t len) {
+	if (out_len + len > sizeof(out_bufs[0]) && !flush_output(file)) {
+		return false;
+	}
+	memcpy(out_buf + out_len, line, len);
+	out_len += len;
+	return true;
+}
 
+// NOTE: Sums one NUL-terminated line; writes the result or an "ERROR: " line into `out`
+static int sum_line(char *ptr, char *out, size_t out_size, bool *failed) {
 	float sum = 0.0f;
 	int count = 0;
-	char *ptr = buf;
 	char *endptr;
 	while (*ptr) {
-		// NOTE: Skip whitespace characters in the input, but stop at newline
-		if (isspace(*ptr) && *ptr != '\n') {
+		// NOTE: Skip whitespace characters in the input
+		if (isspace(*ptr)) {
 			ptr++;
 			continue;
 		}
-		if (*ptr == '\n') {
-			break;
-		}
 		float num = strtof(ptr, &endptr);
 
 		if (num == HUGE_VALF || num == -HUGE_VALF) {
-			const char msg[] = "ERROR: Number out of range\n";
-			write(STDOUT_FILENO, msg, sizeof(msg) - 1);
-			exit(EXIT_FAILURE);
+			*failed = true;
+			return snprintf(out, out_size, "ERROR: Number out of range\n");
 		}
 
 		if (ptr == endptr) {
-			const char msg[] = "ERROR: Invalid character in input\n";
-			write(STDOUT_FILENO, msg, sizeof(msg) - 1);
-			exit(EXIT_FAILURE);
+			*failed = true;
+			return snprintf(out, out_size, "ERROR: Invalid character in input\n");
 		}
 		sum += num;
 		count++;
 		if (isinf(sum)) {
-			const char msg[] = "ERROR: Sum overflow\n";
-			write(STDOUT_FILENO, msg, sizeof(msg) - 1);
-			exit(EXIT_FAILURE);
+			*failed = true;
+			return snprintf(out, out_size, "ERROR: Sum overflow\n");
 		}
 		ptr = endptr;
 	}
 
 	if (count == 0) {
-		const char msg[] = "ERROR: No numbers provided\n";
-		write(STDOUT_FILENO, msg, sizeof(msg) - 1);
-		exit(EXIT_FAILURE);
+		*failed = true;
+		return snprintf(out, out_size, "ERROR: No numbers provided\n");
 	}
 
-	// NOTE: Format the computed sum as a string and write it to file
-	char sum_str[64];
-	int len = snprintf(sum_str, sizeof(sum_str), "%.2f\n", sum);
-	int32_t written = write(file, sum_str, len);
-	if (written != len) {
-		const char msg[] = "ERROR: Failed to write to file\n";
+	// NOTE: Format the computed sum as a string
+	return snprintf(out, out_size, "%.2f\n", sum);
+}
+
+int main(int argc, char **argv) {
+	char buf[4096];
+	ssize_t bytes;
+
+	// NOTE: `O_WRONLY` only enables file for writing
+	// NOTE: `O_CREAT` creates the requested file if absent
+	// NOTE: `O_TRUNC` empties the file prior to opening
+	// NOTE: `O_APPEND` subsequent writes are being appended instead of overwritten
+	// NOTE: `--worker` is one of several children of `parent --workers N`: every line starts
+	//       with its sequence number, which is repeated before the result
+	bool worker = argc > 1 && strcmp(argv[1], "--worker") == 0;
+	int32_t file = worker ? -1 : open(argv[1], O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0600);
+	if (!worker && file == -1) {
+		const char msg[] = "ERROR: Failed to open requested file\n";
 		write(STDOUT_FILENO, msg, sizeof(msg) - 1);
-		exit(EXIT_FAILURE);
+		_exit(EXIT_FAILURE);
 	}
 
-	// NOTE: Also write the sum to standard output
-	int32_t stdout_written = write(STDOUT_FILENO, sum_str, len);
-	if (stdout_written != len) {
-		const char msg[] = "ERROR: Failed to write to stdout\n";
+	// NOTE: A line may be split between reads, so its beginning is kept in `line`
+	//       until the newline arrives; the buffer grows for lines longer than `buf`
+	size_t line_cap = sizeof(buf);
+	size_t line_len = 0;
+	char *line = malloc(line_cap);
+	if (line == NULL) {
+		const char msg[] = "ERROR: Failed to allocate line buffer\n";
 		write(STDOUT_FILENO, msg, sizeof(msg) - 1);
 		exit(EXIT_FAILURE);
 	}
-	
-	close(file);
-}
\ No newline at end of file
+
+	bool failed = false;
+	bool eof = false;
+	while (!eof) {
+		// NOTE: Read input data from standard input until the parent closes the pipe
+		bytes = read(STDIN_FILENO, buf, sizeof(buf));
+		if (bytes < 0) {
+			const char msg[] = "ERROR: Failed to read from stdin\n";
+			write(STDOUT_FILENO, msg, sizeof(msg) - 1);
+			exit(EXIT_FAILURE);
+		}
+		eof = bytes == 0;
+
+		for (ssize_t i = 0; i < bytes || (eof && line_len > 0); ++i) {
+			// NOTE: At the end of input the last line may lack its newline
+			bool end_of_line = i >= bytes || buf[i] == '\n';
+			if (!end_of_line) {
+				if (line_len + 1 >= line_cap) {
+					char *grown = realloc(line, line_cap * 2);
+					if (grown == NULL) {
+						const char msg[] = "ERROR: Line is too long\n";
+						write(STDOUT_FILENO, msg, sizeof(msg) - 1);
+						exit(EXIT_FAILURE);
+					}
+					line = grown;
+					line_cap *= 2;
+				}
+				line[line_len++] = buf[i];
+				continue;
+			}
+
+			line[line_len] = '\0';
+			char result[96];
+			int len = 0;
+			char *numbers = line;
+			if (worker) {
+				char *endptr;
+				unsigned long long seq = strtoull(line, &endptr, 10);
+				if (endptr == line || *endptr != ' ') {
+					const char msg[] = "ERROR: Line without sequence number\n";
+					write(STDOUT_FILENO, msg, sizeof(msg) - 1);
+					exit(EXIT_FAILURE);
+				}
+				len = snprintf(result, sizeof(result), "%llu ", seq);
+				numbers = endptr + 1;
+			}
+			len += sum_line(numbers, result + len, sizeof(result) - len, &failed);
+			if (!emit(file, result, len)) {
+				exit(EXIT_FAILURE);
+			}
+			line_len = 0;
+			if (i >= bytes) {
+				break;
+			}
+		}
+
+		// NOTE: Results of everything read so far are returned before blocking on the next read
+		if (out_len > 0 && !flush_output(file)) {
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	free(line);
+	if (file != -1)
+		close(file);
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
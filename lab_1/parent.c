@@ -1,3 +1,5 @@
+#define _GNU_SOURCE
+
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -7,17 +9,420 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
 
 static char SERVER_PROGRAM_NAME[] = "child";
 
+// NOTE: Upper bound for `--workers`, far above the core count of any machine we run on
+#define MAX_WORKERS 256
+
+// NOTE: Input lines queued for all workers before the parent stops reading stdin
+#define MAX_QUEUED_BYTES (1 << 20)
+
+// NOTE: Requested capacity of the session pipes; the kernel caps it at
+//       /proc/sys/fs/pipe-max-size, and the default 64 KiB still works if the request fails
+#define PIPE_SIZE (1 << 20)
+
+// NOTE: Writes complete lines from the child: results to STDOUT, lines with the "ERROR: "
+//       prefix to STDERR without the prefix. Consecutive results are written with one call.
+//       Returns the number of bytes consumed; an incomplete last line is left unless `last`.
+static size_t write_results(const char *data, size_t len, bool last) {
+	const char error_prefix[] = "ERROR: ";
+	size_t run = 0, pos = 0;
+	while (pos < len) {
+		const char *eol = memchr(data + pos, '\n', len - pos);
+		if (eol == NULL && !last)
+			break;
+		size_t next = eol ? (size_t)(eol - data) + 1 : len;
+		if (next - pos >= sizeof(error_prefix) - 1
+		    && strncmp(data + pos, error_prefix, sizeof(error_prefix) - 1) == 0) {
+			write(STDOUT_FILENO, data + run, pos - run);
+			write(STDERR_FILENO, data + pos + sizeof(error_prefix) - 1,
+			      next - pos - (sizeof(error_prefix) - 1));
+			run = next;
+		}
+		pos = next;
+	}
+	write(STDOUT_FILENO, data + run, pos - run);
+	return pos;
+}
+
+static void fatal(const char *msg) {
+	write(STDERR_FILENO, msg, strlen(msg));
+	exit(EXIT_FAILURE);
+}
+
+static bool write_all(int fd, const char *data, size_t len) {
+	while (len > 0) {
+		ssize_t written = write(fd, data, len);
+		if (written <= 0)
+			return false;
+		data += written;
+		len -= written;
+	}
+	return true;
+}
+
+// NOTE: One child of `--workers N` with its own pair of pipes
+typedef struct {
+	pid_t pid;
+	int to_child;
+	int from_child;
+	bool input_open;
+	bool output_open;
+	size_t pending;    // NOTE: Lines sent to the child and not answered yet
+
+	// NOTE: Tagged lines waiting until the pipe accepts them
+	char *out;
+	size_t out_len, out_off, out_cap;
+
+	// NOTE: The last incomplete result line
+	char in[4096];
+	size_t in_len;
+} Worker;
+
+// NOTE: Result of one line, kept until every earlier line is answered
+typedef struct {
+	bool ready;
+	bool error;
+	uint8_t len;
+	char text[61];
+} Slot;
+
+// NOTE: Results by sequence number in a ring of `cap` slots: `next_out` is the first line
+//       not written yet, `next_seq` is the number the next input line gets
+typedef struct {
+	Slot *slots;
+	size_t cap;
+	uint64_t next_seq;
+	uint64_t next_out;
+} Reorder;
+
+static void spawn_worker(const char *progpath, Worker *worker) {
+	int parent_to_child[2];
+	int child_to_parent[2];
+	if (pipe(parent_to_child) == -1 || pipe(child_to_parent) == -1)
+		fatal("Failed to create pipe\n");
+
+	// NOTE: Workers spawned later must not inherit the parent's ends of earlier pipes,
+	//       otherwise an earlier worker never sees the end of its input
+	fcntl(parent_to_child[1], F_SETFD, FD_CLOEXEC);
+	fcntl(child_to_parent[0], F_SETFD, FD_CLOEXEC);
+
+	const pid_t child = fork();
+	if (child == -1)
+		fatal("Failed to spawn new process\n");
+
+	if (child == 0) {
+		close(parent_to_child[1]);
+		close(child_to_parent[0]);
+
+		dup2(parent_to_child[0], STDIN_FILENO);
+		close(parent_to_child[0]);
+
+		dup2(child_to_parent[1], STDOUT_FILENO);
+		close(child_to_parent[1]);
+
+		char path[4096];
+		snprintf(path, sizeof(path) - 1, "%s/%s", progpath, SERVER_PROGRAM_NAME);
+		char *const args[] = {SERVER_PROGRAM_NAME, "--worker", NULL};
+		execv(path, args);
+		fatal("Failed to exec into new exectuable image\n");
+	}
+
+	close(parent_to_child[0]);
+	close(child_to_parent[1]);
+	fcntl(parent_to_child[1], F_SETFL, fcntl(parent_to_child[1], F_GETFL) | O_NONBLOCK);
+
+	memset(worker, 0, sizeof(*worker));
+	worker->pid = child;
+	worker->to_child = parent_to_child[1];
+	worker->from_child = child_to_parent[0];
+	worker->input_open = true;
+	worker->output_open = true;
+}
+
+// NOTE: Tags the line with the next sequence number and queues it for the least loaded worker
+static void dispatch_line(Worker *workers, int count, Reorder *reorder, const char *line, size_t len) {
+	Worker *worker = NULL;
+	for (int i = 0; i < count; ++i) {
+		if (workers[i].input_open && (worker == NULL || workers[i].pending < worker->pending))
+			worker = &workers[i];
+	}
+	if (worker == NULL)
+		fatal("All workers have exited\n");
+
+	if (reorder->next_seq - reorder->next_out == reorder->cap) {
+		size_t cap = reorder->cap * 2;
+		Slot *slots = calloc(cap, sizeof(Slot));
+		if (slots == NULL)
+			fatal("Failed to allocate result buffer\n");
+		for (uint64_t seq = reorder->next_out; seq < reorder->next_seq; ++seq)
+			slots[seq % cap] = reorder->slots[seq % reorder->cap];
+		free(reorder->slots);
+		reorder->slots = slots;
+		reorder->cap = cap;
+	}
+
+	size_t need = 24 + len + 1;
+	if (worker->out_len + need > worker->out_cap) {
+		if (worker->out_off > 0) {
+			memmove(worker->out, worker->out + worker->out_off, worker->out_len - worker->out_off);
+			worker->out_len -= worker->out_off;
+			worker->out_off = 0;
+		}
+		while (worker->out_len + need > worker->out_cap) {
+			worker->out_cap = worker->out_cap ? worker->out_cap * 2 : 65536;
+			worker->out = realloc(worker->out, worker->out_cap);
+			if (worker->out == NULL)
+				fatal("Failed to allocate worker buffer\n");
+		}
+	}
+	worker->out_len += snprintf(worker->out + worker->out_len, 24, "%llu ",
+	                            (unsigned long long)reorder->next_seq);
+	memcpy(worker->out + worker->out_len, line, len);
+	worker->out_len += len;
+	worker->out[worker->out_len++] = '\n';
+	worker->pending++;
+	reorder->next_seq++;
+}
+
+// NOTE: Stores complete result lines "seq result" of one worker; returns false on a line
+//       without a valid sequence number, which is the worker's own fatal error
+static bool collect_results(Worker *worker, Reorder *reorder) {
+	const char error_prefix[] = "ERROR: ";
+	size_t pos = 0;
+	bool ok = true;
+	while (pos < worker->in_len) {
+		char *line = worker->in + pos;
+		char *eol = memchr(line, '\n', worker->in_len - pos);
+		if (eol == NULL)
+			break;
+		pos = eol - worker->in + 1;
+
+		char *endptr;
+		unsigned long long seq = strtoull(line, &endptr, 10);
+		size_t len = eol + 1 - (endptr + 1);
+		if (endptr == line || *endptr != ' ' || seq < reorder->next_out || seq >= reorder->next_seq
+		    || len > sizeof(((Slot *)0)->text)) {
+			bool error = strncmp(line, error_prefix, sizeof(error_prefix) - 1) == 0;
+			size_t skip = error ? sizeof(error_prefix) - 1 : 0;
+			write(STDERR_FILENO, line + skip, eol + 1 - line - skip);
+			ok = false;
+			continue;
+		}
+		Slot *slot = &reorder->slots[seq % reorder->cap];
+		slot->ready = true;
+		slot->error = strncmp(endptr + 1, error_prefix, sizeof(error_prefix) - 1) == 0;
+		slot->len = len;
+		memcpy(slot->text, endptr + 1, len);
+		worker->pending--;
+	}
+	memmove(worker->in, worker->in + pos, worker->in_len - pos);
+	worker->in_len -= pos;
+	return ok;
+}
+
+// NOTE: `parent --workers N`: lines are spread over N children, and their results are
+//       put back in input order before they reach STDOUT and the file
+static int run_workers(const char *progpath, const char *filename, int count) {
+	int32_t file = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0600);
+	if (file == -1)
+		fatal("Failed to open requested file\n");
+
+	signal(SIGPIPE, SIG_IGN);
+
+	Worker *workers = calloc(count, sizeof(Worker));
+	struct pollfd *fds = calloc(2 * count + 1, sizeof(struct pollfd));
+	Reorder reorder = {calloc(1024, sizeof(Slot)), 1024, 0, 0};
+	if (workers == NULL || fds == NULL || reorder.slots == NULL)
+		fatal("Failed to allocate workers\n");
+	for (int i = 0; i < count; ++i)
+		spawn_worker(progpath, &workers[i]);
+
+	char buf[65536];
+	char *line = NULL;
+	size_t line_len = 0, line_cap = 0;
+	bool input_open = true;
+	bool failed = false;
+	int open_outputs = count;
+
+	// NOTE: Results that are next in order are batched here for STDOUT and the file
+	char ordered[65536];
+	size_t ordered_len = 0;
+
+	while (open_outputs > 0) {
+		size_t queued = 0;
+		for (int i = 0; i < count; ++i)
+			queued += workers[i].out_len - workers[i].out_off;
+
+		nfds_t nfds = 0;
+		int stdin_idx = -1;
+		if (input_open && queued < MAX_QUEUED_BYTES) {
+			stdin_idx = nfds;
+			fds[nfds++] = (struct pollfd){.fd = STDIN_FILENO, .events = POLLIN};
+		}
+		for (int i = 0; i < count; ++i) {
+			Worker *w = &workers[i];
+			if (w->input_open && w->out_off < w->out_len)
+				fds[nfds++] = (struct pollfd){.fd = w->to_child, .events = POLLOUT};
+			if (w->output_open)
+				fds[nfds++] = (struct pollfd){.fd = w->from_child, .events = POLLIN};
+		}
+
+		if (poll(fds, nfds, -1) == -1) {
+			if (errno == EINTR)
+				continue;
+			fatal("Failed to poll pipes\n");
+		}
+
+		if (stdin_idx >= 0 && fds[stdin_idx].revents) {
+			ssize_t bytes = read(STDIN_FILENO, buf, sizeof(buf));
+			if (bytes < 0)
+				fatal("Failed to read from stdin\n");
+
+			// NOTE: Complete lines are dispatched straight from `buf`, only a line split
+			//       between reads is gathered in `line`
+			char *ptr = buf;
+			char *end = buf + bytes;
+			while (ptr < end) {
+				char *eol = memchr(ptr, '\n', end - ptr);
+				char *stop = eol ? eol : end;
+				if (eol != NULL && line_len == 0) {
+					dispatch_line(workers, count, &reorder, ptr, stop - ptr);
+				} else {
+					if (line_len + (stop - ptr) > line_cap) {
+						line_cap = line_len + (stop - ptr) + 4096;
+						line = realloc(line, line_cap);
+						if (line == NULL)
+							fatal("Failed to allocate line buffer\n");
+					}
+					memcpy(line + line_len, ptr, stop - ptr);
+					line_len += stop - ptr;
+					if (eol != NULL) {
+						dispatch_line(workers, count, &reorder, line, line_len);
+						line_len = 0;
+					}
+				}
+				ptr = eol ? eol + 1 : end;
+			}
+
+			if (bytes == 0) {
+				// NOTE: The last line may lack its newline
+				if (line_len > 0)
+					dispatch_line(workers, count, &reorder, line, line_len);
+				input_open = false;
+			}
+		}
+
+		for (nfds_t f = stdin_idx >= 0 ? 1 : 0; f < nfds; ++f) {
+			if (!fds[f].revents)
+				continue;
+			for (int i = 0; i < count; ++i) {
+				Worker *w = &workers[i];
+				if (fds[f].fd == w->to_child && w->input_open) {
+					ssize_t written = write(w->to_child, w->out + w->out_off, w->out_len - w->out_off);
+					if (written > 0) {
+						w->out_off += written;
+					} else if (written < 0 && errno != EAGAIN) {
+						// NOTE: The worker has gone; its output tells what happened
+						w->input_open = false;
+						close(w->to_child);
+					}
+				} else if (fds[f].fd == w->from_child && w->output_open) {
+					ssize_t bytes = read(w->from_child, w->in + w->in_len, sizeof(w->in) - w->in_len);
+					if (bytes < 0)
+						fatal("Failed to read from child pipe\n");
+					if (bytes == 0) {
+						w->output_open = false;
+						--open_outputs;
+						close(w->from_child);
+						if (w->pending > 0 || w->in_len > 0)
+							fatal("Worker exited before answering all lines\n");
+					}
+					w->in_len += bytes;
+					if (!collect_results(w, &reorder))
+						failed = true;
+				}
+			}
+		}
+
+		// NOTE: Workers whose lines are all sent learn about the end of input
+		for (int i = 0; i < count; ++i) {
+			Worker *w = &workers[i];
+			if (!input_open && w->input_open && w->out_off == w->out_len) {
+				w->input_open = false;
+				close(w->to_child);
+			}
+		}
+
+		while (reorder.next_out < reorder.next_seq && reorder.slots[reorder.next_out % reorder.cap].ready) {
+			Slot *slot = &reorder.slots[reorder.next_out % reorder.cap];
+			if (slot->error || ordered_len + slot->len > sizeof(ordered)) {
+				if (!write_all(STDOUT_FILENO, ordered, ordered_len) || !write_all(file, ordered, ordered_len))
+					fatal("Failed to write results\n");
+				ordered_len = 0;
+			}
+			if (slot->error) {
+				const char error_prefix[] = "ERROR: ";
+				write(STDERR_FILENO, slot->text + sizeof(error_prefix) - 1, slot->len - (sizeof(error_prefix) - 1));
+				failed = true;
+			} else {
+				memcpy(ordered + ordered_len, slot->text, slot->len);
+				ordered_len += slot->len;
+			}
+			slot->ready = false;
+			reorder.next_out++;
+		}
+		if (!write_all(STDOUT_FILENO, ordered, ordered_len) || !write_all(file, ordered, ordered_len))
+			fatal("Failed to write results\n");
+		ordered_len = 0;
+	}
+
+	for (int i = 0; i < count; ++i) {
+		int status;
+		if (waitpid(workers[i].pid, &status, 0) == -1)
+			fatal("Failed to wait for child\n");
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			failed = true;
+		free(workers[i].out);
+	}
+	close(file);
+	free(line);
+	free(fds);
+	free(workers);
+	free(reorder.slots);
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
 int main(int argc, char **argv) {
 	if (argc == 1) {
 		char msg[1024];
-		uint32_t len = snprintf(msg, sizeof(msg) - 1, "usage: %s filename\n", argv[0]);
+		uint32_t len = snprintf(msg, sizeof(msg) - 1, "usage: %s [--workers N] filename\n", argv[0]);
 		write(STDERR_FILENO, msg, len);
 		exit(EXIT_SUCCESS);
 	}
 
+	// NOTE: `--workers N` spreads the lines over N children instead of one
+	const char *filename = argv[1];
+	int workers = 0;
+	if (strcmp(argv[1], "--workers") == 0) {
+		char *endptr;
+		long count = argc > 2 ? strtol(argv[2], &endptr, 10) : 0;
+		if (argc != 4 || *endptr != '\0' || count < 1 || count > MAX_WORKERS) {
+			char msg[1024];
+			uint32_t len = snprintf(msg, sizeof(msg) - 1, "usage: %s [--workers N] filename, N from 1 to %d\n",
+			                        argv[0], MAX_WORKERS);
+			write(STDERR_FILENO, msg, len);
+			exit(EXIT_FAILURE);
+		}
+		workers = (int)count;
+		filename = argv[3];
+	}
+
 	// NOTE: Get full path to the directory, where program resides
 	char progpath[2048];
 	{
@@ -37,6 +442,9 @@ int main(int argc, char **argv) {
 		progpath[len] = '\0';
 	}
 
+	if (workers > 0)
+		exit(run_workers(progpath, filename, workers));
+
 	// NOTE: Open pipes
 	int parent_to_child[2];
 	if (pipe(parent_to_child) == -1) {
@@ -53,6 +461,10 @@ int main(int argc, char **argv) {
 		exit(EXIT_FAILURE);
 	}
 
+	// NOTE: Fewer, larger transfers per megabyte of input and results
+	fcntl(parent_to_child[1], F_SETPIPE_SZ, PIPE_SIZE);
+	fcntl(child_to_parent[1], F_SETPIPE_SZ, PIPE_SIZE);
+
 	// NOTE: Spawn a new process
 	const pid_t child = fork();
 
@@ -79,7 +491,7 @@ int main(int argc, char **argv) {
 			// NOTE: args[0] must be a program name, next the actual arguments
 			// NOTE: `NULL` at the end is mandatory, because `exec*`
 			//       expects a NULL-terminated list of C-strings
-			char *const args[] = {SERVER_PROGRAM_NAME, argv[1], NULL};
+			char *const args[] = {SERVER_PROGRAM_NAME, (char *)filename, NULL};
 
 			int32_t status = execv(path, args);
 
@@ -92,43 +504,128 @@ int main(int argc, char **argv) {
 	} break;
 
 	default: { // NOTE: We're a parent
+		close(parent_to_child[0]);
+		close(child_to_parent[1]);
+
+		// NOTE: The child blocks on writing results while the parent blocks on writing input
+		//       if both pipes fill up, so input is written without blocking and `poll` waits
+		//       for whichever side can make progress
+		fcntl(parent_to_child[1], F_SETFL, fcntl(parent_to_child[1], F_GETFL) | O_NONBLOCK);
+
+		// NOTE: A child that exits early must not kill the parent with SIGPIPE
+		signal(SIGPIPE, SIG_IGN);
 
 		char buf[4096];
-		ssize_t bytes;
+		size_t buf_len = 0, buf_off = 0;
+		bool input_open = true;
+		bool child_open = true;
 
-		while (bytes = read(STDIN_FILENO, buf, sizeof(buf))) {
-			if (bytes < 0) {
-				const char msg[] = "Failed to read from stdin\n";
+		// NOTE: The single child is the only consumer of stdin, so the bytes are moved from stdin
+		//       into its pipe by `splice` without passing through `buf`. When stdin does not
+		//       support it (a terminal), `read` and `write` are used instead.
+		bool use_splice = true;
+		bool pipe_full = false;
+
+		// NOTE: Results come back split at arbitrary points, so the last incomplete line is kept
+		char result_buf[8192];
+		size_t result_len = 0;
+
+		while (child_open) {
+			struct pollfd fds[3];
+			nfds_t nfds = 0;
+			int stdin_idx = -1, to_child_idx = -1, from_child_idx;
+			if (input_open && buf_off == buf_len && !pipe_full) {
+				stdin_idx = nfds;
+				fds[nfds++] = (struct pollfd){.fd = STDIN_FILENO, .events = POLLIN};
+			}
+			if (buf_off < buf_len || pipe_full) {
+				to_child_idx = nfds;
+				fds[nfds++] = (struct pollfd){.fd = parent_to_child[1], .events = POLLOUT};
+			}
+			from_child_idx = nfds;
+			fds[nfds++] = (struct pollfd){.fd = child_to_parent[0], .events = POLLIN};
+
+			if (poll(fds, nfds, -1) == -1) {
+				if (errno == EINTR)
+					continue;
+				const char msg[] = "Failed to poll pipes\n";
 				write(STDERR_FILENO, msg, sizeof(msg));
 				exit(EXIT_FAILURE);
 			}
 
-			write(parent_to_child[1], buf, bytes);
-			break;  // NOTE: Exit after first input
-		}
+			if (stdin_idx >= 0 && fds[stdin_idx].revents && use_splice) {
+				ssize_t moved = splice(STDIN_FILENO, NULL, parent_to_child[1], NULL, PIPE_SIZE,
+				                       SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+				if (moved == 0) {
+					input_open = false;
+					close(parent_to_child[1]);
+				} else if (moved < 0 && errno == EAGAIN) {
+					// NOTE: Usually the child's pipe is full: wait until it drains. If it was stdin
+					//       that had nothing, the pipe is writable at once and stdin is polled again.
+					pipe_full = true;
+				} else if (moved < 0 && errno == EPIPE) {
+					input_open = false;
+					close(parent_to_child[1]);
+				} else if (moved < 0 && errno == EINVAL) {
+					use_splice = false;
+				} else if (moved < 0) {
+					const char msg[] = "Failed to read from stdin\n";
+					write(STDERR_FILENO, msg, sizeof(msg));
+					exit(EXIT_FAILURE);
+				}
+			}
 
-		close(parent_to_child[1]);
-		close(child_to_parent[1]);
+			if (stdin_idx >= 0 && fds[stdin_idx].revents && !use_splice) {
+				ssize_t bytes = read(STDIN_FILENO, buf, sizeof(buf));
+				if (bytes < 0) {
+					const char msg[] = "Failed to read from stdin\n";
+					write(STDERR_FILENO, msg, sizeof(msg));
+					exit(EXIT_FAILURE);
+				}
+				buf_len = bytes;
+				buf_off = 0;
+				if (bytes == 0) {
+					// NOTE: End of input: the child finishes the last line and exits
+					input_open = false;
+					close(parent_to_child[1]);
+				}
+			}
 
-		char result_buf[4096];
-		ssize_t result_bytes = read(child_to_parent[0], result_buf, sizeof(result_buf));
-		if (result_bytes > 0) {
-			// NOTE: Check if the output from child starts with "ERROR: " prefix
-			// If yes, it's an error message, so write to STDERR; otherwise, it's the result, write to STDOUT
-			const char error_prefix[] = "ERROR: ";
-			int output_fd = STDOUT_FILENO;
-			size_t offset = 0;
-			if (result_bytes >= sizeof(error_prefix) - 1 && strncmp(result_buf, error_prefix, sizeof(error_prefix) - 1) == 0) {
-				output_fd = STDERR_FILENO;
-				offset = sizeof(error_prefix) - 1;  // Skip the "ERROR: " prefix when writing
+			if (to_child_idx >= 0 && fds[to_child_idx].revents && pipe_full) {
+				pipe_full = false;
+			} else if (to_child_idx >= 0 && fds[to_child_idx].revents) {
+				ssize_t written = write(parent_to_child[1], buf + buf_off, buf_len - buf_off);
+				if (written > 0) {
+					buf_off += written;
+				} else if (written < 0 && errno != EAGAIN) {
+					// NOTE: The child has gone; its output still tells what happened
+					input_open = false;
+					buf_off = buf_len;
+					close(parent_to_child[1]);
+				}
+			}
+
+			if (fds[from_child_idx].revents) {
+				ssize_t result_bytes = read(child_to_parent[0], result_buf + result_len,
+				                            sizeof(result_buf) - result_len);
+				if (result_bytes < 0) {
+					const char msg[] = "Failed to read from child pipe\n";
+					write(STDERR_FILENO, msg, sizeof(msg));
+					exit(EXIT_FAILURE);
+				}
+				if (result_bytes == 0) {
+					child_open = false;
+				}
+				result_len += result_bytes;
+				size_t done = write_results(result_buf, result_len, !child_open);
+				memmove(result_buf, result_buf + done, result_len - done);
+				result_len -= done;
 			}
-			write(output_fd, result_buf + offset, result_bytes - offset);
-		} else if (result_bytes < 0) {
-			const char msg[] = "Failed to read from child pipe\n";
-			write(STDERR_FILENO, msg, sizeof(msg));
-			exit(EXIT_FAILURE);
 		}
 
+		if (input_open) {
+			close(parent_to_child[1]);
+		}
 		close(child_to_parent[0]);
 
 		int status;
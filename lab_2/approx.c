@@ -0,0 +1,208 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "approx.h"
+
+// Квадрат нормы (b - a) x (c - a), то есть учетверённый квадрат площади
+static double cross2(const float (*xyz)[3], int a, int b, int c) {
+    double ux = (double)xyz[b][0] - xyz[a][0], uy = (double)xyz[b][1] - xyz[a][1], uz = (double)xyz[b][2] - xyz[a][2];
+    double wx = (double)xyz[c][0] - xyz[a][0], wy = (double)xyz[c][1] - xyz[a][1], wz = (double)xyz[c][2] - xyz[a][2];
+    double cx = uy * wz - uz * wy;
+    double cy = uz * wx - ux * wz;
+    double cz = ux * wy - uy * wx;
+    return cx * cx + cy * cy + cz * cz;
+}
+
+static int farthest(const float (*xyz)[3], const int* idx, int m, int from) {
+    double best = -1.0;
+    int best_p = from;
+    for (int t = 0; t < m; ++t) {
+        double dx = (double)xyz[idx[t]][0] - xyz[from][0];
+        double dy = (double)xyz[idx[t]][1] - xyz[from][1];
+        double dz = (double)xyz[idx[t]][2] - xyz[from][2];
+        double d2 = dx * dx + dy * dy + dz * dz;
+        if (d2 > best) {
+            best = d2;
+            best_p = idx[t];
+        }
+    }
+    return best_p;
+}
+
+// Локальный поиск; v[3] — вершины, возвращает итоговый квадрат
+static double local_search(const float (*xyz)[3], const int* idx, int m, int* v) {
+    double best = cross2(xyz, v[0], v[1], v[2]);
+    int improved = 1;
+    // Каждый шаг строго увеличивает площадь, число шагов ограничено на случай ошибок округления
+    for (int round = 0; improved && round < 64; ++round) {
+        improved = 0;
+        for (int pos = 0; pos < 3; ++pos) {
+            int a = v[(pos + 1) % 3], b = v[(pos + 2) % 3];
+            for (int t = 0; t < m; ++t) {
+                double value = cross2(xyz, a, b, idx[t]);
+                if (value > best) {
+                    best = value;
+                    v[pos] = idx[t];
+                    improved = 1;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+static int cmp_int(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+typedef struct {
+    const float (*xyz)[3];
+    const int* idx;
+    int m;
+    int grid;
+    int d_begin, d_end;
+    int* extreme;
+} ExtremeArgs;
+
+// Номер направления: грань, затем строка и столбец ячейки
+void approx_direction(int g, int d, double dir[3]) {
+    int face = d / (g * g);
+    int axis = face / 2;
+    dir[axis] = face % 2 ? -1.0 : 1.0;
+    dir[(axis + 1) % 3] = -1.0 + (2.0 * (d / g % g) + 1.0) / g;
+    dir[(axis + 2) % 3] = -1.0 + (2.0 * (d % g) + 1.0) / g;
+}
+
+// Крайние точки для направлений [d_begin, d_end)
+static void ExtremePart(void* arg) {
+    ExtremeArgs* args = (ExtremeArgs*) arg;
+    for (int d = args->d_begin; d < args->d_end; ++d) {
+        double dir[3];
+        approx_direction(args->grid, d, dir);
+        double best = -INFINITY;
+        int best_p = args->idx[0];
+        for (int t = 0; t < args->m; ++t) {
+            const float* p = args->xyz[args->idx[t]];
+            double value = dir[0] * p[0] + dir[1] * p[1] + dir[2] * p[2];
+            if (value > best) {
+                best = value;
+                best_p = args->idx[t];
+            }
+        }
+        args->extreme[d] = best_p;
+    }
+}
+
+int approx_candidates(const float (*xyz)[3], const int* idx, int m, ThreadPool* pool, Approx* approx, int* out) {
+    approx->grid = 0;
+    approx->loss = 0.0;
+    approx->area = 0.0;
+    approx->i = approx->j = approx->k = -1;
+    memcpy(out, idx, m * sizeof(int));
+    if (m < 3) {
+        return m;
+    }
+
+    // Быстрый треугольник: самая дальняя пара и лучшая к ней третья точка с локальным поиском
+    int v[3];
+    v[0] = farthest(xyz, idx, m, idx[0]);
+    v[1] = farthest(xyz, idx, m, v[0]);
+    v[2] = v[0];
+    double seed = local_search(xyz, idx, m, v);
+    // Все точки на одной прямой или совпадают: треугольника нет, и номера остаются -1
+    if (seed <= 0.0) {
+        return m;
+    }
+    approx->i = v[0];
+    approx->j = v[1];
+    approx->k = v[2];
+    approx->area = 0.5 * sqrt(seed);
+
+    double lo[3] = {xyz[idx[0]][0], xyz[idx[0]][1], xyz[idx[0]][2]};
+    double hi[3] = {lo[0], lo[1], lo[2]};
+    for (int t = 1; t < m; ++t) {
+        for (int c = 0; c < 3; ++c) {
+            if (xyz[idx[t]][c] < lo[c]) lo[c] = xyz[idx[t]][c];
+            if (xyz[idx[t]][c] > hi[c]) hi[c] = xyz[idx[t]][c];
+        }
+    }
+    double r2 = 0.0;
+    for (int t = 0; t < m; ++t) {
+        double d2 = 0.0;
+        for (int c = 0; c < 3; ++c) {
+            double diff = xyz[idx[t]][c] - (lo[c] + hi[c]) / 2;
+            d2 += diff * diff;
+        }
+        if (d2 > r2) r2 = d2;
+    }
+
+    // loss = 6·R²·√2/g <= eps / (1 - eps) · area; при таком g направлений не меньше, чем точек,
+    // и сокращать нечего
+    double grid = ceil(6.0 * sqrt(2.0) * r2 * (1.0 - approx->eps) / (approx->eps * approx->area));
+    if (6.0 * grid * grid >= m) {
+        return m;
+    }
+    int g = (int)grid;
+    int directions = 6 * g * g;
+    int* extreme = malloc(directions * sizeof(int));
+    int parts = pool ? pool_workers(pool) : 1;
+    if (parts > directions) {
+        parts = directions;
+    }
+    ExtremeArgs* args = malloc(parts * sizeof(ExtremeArgs));
+    // Без памяти на направления кандидатами остаются все точки: ответ тот же, только медленнее
+    if (extreme == NULL || args == NULL) {
+        free(extreme);
+        free(args);
+        return m;
+    }
+    TaskGroup group = {0};
+    for (int t = 0; t < parts; ++t) {
+        args[t] = (ExtremeArgs){xyz, idx, m, g, (int)((long long)directions * t / parts),
+                                (int)((long long)directions * (t + 1) / parts), extreme};
+        if (pool && parts > 1) {
+            pool_submit(pool, &group, ExtremePart, &args[t]);
+        } else {
+            ExtremePart(&args[t]);
+        }
+    }
+    if (pool && parts > 1) {
+        pool_wait(pool, &group);
+    }
+
+    qsort(extreme, directions, sizeof(int), cmp_int);
+    int count = 0;
+    for (int d = 0; d < directions; ++d) {
+        if (count == 0 || out[count - 1] != extreme[d]) {
+            out[count++] = extreme[d];
+        }
+    }
+    approx->grid = g;
+    approx->loss = approx_loss(r2, g);
+    free(args);
+    free(extreme);
+    return count;
+}
+
+double approx_refine(const float (*xyz)[3], const int* idx, int m, const Approx* approx, int* i, int* j, int* k) {
+    int v[3] = {*i, *j, *k};
+    if (v[0] < 0 || (approx->i >= 0 && cross2(xyz, approx->i, approx->j, approx->k) > cross2(xyz, v[0], v[1], v[2]))) {
+        v[0] = approx->i;
+        v[1] = approx->j;
+        v[2] = approx->k;
+    }
+    if (v[0] < 0) {
+        return 0.0;
+    }
+    double best = local_search(xyz, idx, m, v);
+    qsort(v, 3, sizeof(int), cmp_int);
+    if (best <= 0.0 || v[0] == v[1] || v[1] == v[2]) {
+        *i = *j = *k = -1;
+        return 0.0;
+    }
+    *i = v[0];
+    *j = v[1];
+    *k = v[2];
+    return 0.5 * sqrt(best);
+}
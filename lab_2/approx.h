@@ -0,0 +1,41 @@
+#pragma once
+
+#include <math.h>
+#include "pool.h"
+
+// Приближённый поиск: кандидатами остаются крайние точки по направлениям 6·g² центров
+// ячеек сетки g×g на гранях куба. Любое направление отклоняется от ближайшего из них
+// не больше чем на θ = √2/g, поэтому каждую вершину оптимального треугольника можно
+// заменить кандидатом, потеряв не больше 2R²θ площади (R — радиус сферы вокруг точек).
+// Значит, оптимум не больше площади лучшего треугольника из кандидатов плюс loss = 6R²θ.
+typedef struct {
+    double eps;
+    int grid;           // g; 0 — кандидаты не сокращались, ответ точный
+    double loss;
+    int i, j, k;        // треугольник локального поиска от самой дальней пары, исходные индексы
+    double area;
+} Approx;
+
+// idx — m исходных индексов точек (вершины оболочки). Сетка подбирается так, чтобы
+// loss не превышал eps / (1 - eps) от площади быстрого треугольника. В out (не меньше m
+// элементов) записываются исходные индексы кандидатов по возрастанию, возвращается их число.
+int approx_candidates(const float (*xyz)[3], const int* idx, int m, ThreadPool* pool, Approx* approx, int* out);
+
+// Уточняет треугольник (*i, *j, *k) (или треугольник approx, если он больше) локальным поиском
+// по точкам idx: вершина по очереди заменяется на лучшую при двух других фиксированных.
+// Возвращает площадь результата, вершины записываются по возрастанию; без треугольника
+// ненулевой площади — номера -1 и площадь 0.
+double approx_refine(const float (*xyz)[3], const int* idx, int m, const Approx* approx, int* i, int* j, int* k);
+
+// Направление d из 6·g² (центр ячейки на грани куба [-1, 1]³, не единичной длины)
+void approx_direction(int g, int d, double dir[3]);
+
+// Потеря площади при кандидатах из крайних точек по сетке g для точек в шаре радиуса √r2
+static inline double approx_loss(double r2, int g) {
+    return 6.0 * r2 * sqrt(2.0) / g;
+}
+
+// Гарантированная доля площади от оптимума для найденной площади area
+static inline double approx_ratio(const Approx* approx, double area) {
+    return approx->loss > 0.0 ? area / (area + approx->loss) : 1.0;
+}
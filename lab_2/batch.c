@@ -0,0 +1,229 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "batch.h"
+#include "loader.h"
+
+typedef struct {
+    char* path;
+    const maxtri_opts* opts;
+    int text_scalar_size;   // размер координаты при разборе текстовых наборов
+    TaskGroup group;
+    int n;
+    int status;             // MAXTRI_OK или код ошибки поиска
+    const char* error;      // ошибка загрузки; NULL — набор загружен
+    maxtri_result result;
+    long long ms;
+} BatchSet;
+
+typedef struct {
+    char** paths;
+    int count, cap;
+} PathList;
+
+static int path_push(PathList* list, char* path) {
+    if (path == NULL) {
+        return -1;
+    }
+    if (list->count == list->cap) {
+        int cap = list->cap ? list->cap * 2 : 64;
+        char** grown = realloc(list->paths, cap * sizeof(char*));
+        if (grown == NULL) {
+            free(path);
+            return -1;
+        }
+        list->paths = grown;
+        list->cap = cap;
+    }
+    list->paths[list->count++] = path;
+    return 0;
+}
+
+static void path_list_free(PathList* list) {
+    for (int p = 0; p < list->count; ++p) {
+        free(list->paths[p]);
+    }
+    free(list->paths);
+}
+
+// dir/name; name без изменений, если он абсолютный или dir пуст
+static char* path_join(const char* dir, size_t dir_len, const char* name, size_t name_len) {
+    if (name[0] == '/' || dir_len == 0) {
+        dir_len = 0;
+    }
+    char* path = malloc(dir_len + name_len + 2);
+    if (path != NULL) {
+        memcpy(path, dir, dir_len);
+        if (dir_len > 0) path[dir_len++] = '/';
+        memcpy(path + dir_len, name, name_len);
+        path[dir_len + name_len] = '\0';
+    }
+    return path;
+}
+
+static int path_compare(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static int list_dir(const char* dir, PathList* list) {
+    DIR* d = opendir(dir);
+    if (d == NULL) {
+        return -1;
+    }
+    struct dirent* entry;
+    int status = 0;
+    while (status == 0 && (entry = readdir(d)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        char* path = path_join(dir, strlen(dir), entry->d_name, strlen(entry->d_name));
+        struct stat st;
+        if (path != NULL && (stat(path, &st) != 0 || !S_ISREG(st.st_mode))) {
+            free(path);
+            continue;
+        }
+        status = path_push(list, path);
+    }
+    closedir(d);
+    // Порядок readdir зависит от файловой системы
+    qsort(list->paths, list->count, sizeof(char*), path_compare);
+    return status;
+}
+
+static int list_manifest(const char* manifest, PathList* list) {
+    FILE* file = fopen(manifest, "r");
+    if (file == NULL) {
+        return -1;
+    }
+    const char* slash = strrchr(manifest, '/');
+    size_t dir_len = slash ? (size_t)(slash - manifest) : 0;
+    char* line = NULL;
+    size_t line_cap = 0;
+    ssize_t len;
+    int status = 0;
+    while (status == 0 && (len = getline(&line, &line_cap, file)) >= 0) {
+        char* begin = line;
+        char* end = line + len;
+        while (begin < end && (*begin == ' ' || *begin == '\t')) ++begin;
+        while (end > begin && (end[-1] == '\n' || end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) --end;
+        if (begin == end || *begin == '#') {
+            continue;
+        }
+        status = path_push(list, path_join(manifest, dir_len, begin, end - begin));
+    }
+    free(line);
+    fclose(file);
+    return status;
+}
+
+static long long elapsed_ms(const struct timespec* start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) * 1000LL + (end.tv_nsec - start->tv_nsec) / 1000000LL;
+}
+
+static void BatchWorker(void* arg) {
+    BatchSet* set = (BatchSet*) arg;
+    const maxtri_opts* opts = set->opts;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    PointSet points;
+    set->error = points_load_as(set->path, opts->pool, set->text_scalar_size, &points);
+    if (set->error != NULL) {
+        set->ms = elapsed_ms(&start);
+        return;
+    }
+    set->n = points.n;
+    // Небольшой набор перебирается целиком в этом потоке, а остальные потоки заняты другими наборами
+    maxtri_opts local = *opts;
+    int whole = points.n < BATCH_PARALLEL_POINTS || opts->pool == NULL;
+    if (whole) {
+        local.backend = local.backend == MAXTRI_HULL ? MAXTRI_HULL : MAXTRI_SIMD;
+        local.threads = 1;
+    } else {
+        local.backend = local.backend == MAXTRI_HULL ? MAXTRI_HULL : MAXTRI_THREADS;
+        local.threads = pool_workers(opts->pool);
+    }
+    set->status = points.n < 3 ? MAXTRI_EINVAL
+                : maxtri_find_points(points.data, points.n, points.dim, points.scalar_size, &local, &set->result);
+    points_unload(&points);
+    set->ms = elapsed_ms(&start);
+}
+
+static void print_set(const BatchSet* set) {
+    if (set->error != NULL) {
+        printf("%s: failed to load: %s\n", set->path, set->error);
+    } else if (set->n < 3) {
+        printf("%s: %d points, need at least 3\n", set->path, set->n);
+    } else if (set->status != MAXTRI_OK) {
+        printf("%s: search failed: %s\n", set->path, maxtri_strerror(set->status));
+    } else {
+        static const char* const labels[] = {"max area", "max perimeter", "min area"};
+        const maxtri_triangle* best = &set->result.best;
+        printf("%s: %d points, %s %.2f at points %d, %d, %d, %lld ms", set->path, set->n,
+               labels[set->opts->objective], best->area, best->i, best->j, best->k, set->ms);
+        if (set->result.coverage < 1.0) {
+            printf(", %.1f%% of triples by deadline", set->result.coverage * 100.0);
+        }
+        printf("\n");
+    }
+}
+
+int batch_run(const char* path, const maxtri_opts* opts, int text_scalar_size, int* failed) {
+    *failed = 0;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    PathList list = {NULL, 0, 0};
+    struct stat st;
+    int listed = stat(path, &st) != 0 ? -1 : (S_ISDIR(st.st_mode) ? list_dir(path, &list) : list_manifest(path, &list));
+    if (listed != 0) {
+        printf("Failed to read batch %s\n", path);
+        path_list_free(&list);
+        return MAXTRI_EINVAL;
+    }
+    BatchSet* sets = calloc(list.count > 0 ? list.count : 1, sizeof(BatchSet));
+    if (sets == NULL) {
+        path_list_free(&list);
+        return MAXTRI_ENOMEM;
+    }
+
+    // Наборы ставятся в очередь окном, а ответы выводятся по порядку: ожидая очередной набор,
+    // вызывающий поток сам выполняет задачи из очереди
+    ThreadPool* pool = opts->pool;
+    int window = pool ? pool_workers(pool) * BATCH_WINDOW_PER_THREAD : 1;
+    int submitted = 0;
+    for (int s = 0; s < list.count; ++s) {
+        while (submitted < list.count && submitted < s + window) {
+            BatchSet* set = &sets[submitted++];
+            set->path = list.paths[submitted - 1];
+            set->opts = opts;
+            set->text_scalar_size = text_scalar_size;
+            if (pool != NULL) {
+                pool_submit(pool, &set->group, BatchWorker, set);
+            }
+        }
+        if (pool != NULL) {
+            pool_wait(pool, &sets[s].group);
+        } else {
+            BatchWorker(&sets[s]);
+        }
+        print_set(&sets[s]);
+        // Ответ нужен читающему сразу, даже если вывод идёт в канал
+        fflush(stdout);
+        *failed += sets[s].error != NULL || sets[s].n < 3 || sets[s].status != MAXTRI_OK;
+        if (sets[s].error == NULL && sets[s].status == MAXTRI_OK) {
+            maxtri_result_free(&sets[s].result);
+        }
+    }
+    long long ms = elapsed_ms(&start);
+    printf("Batch of %d sets (%d failed) in %lld ms: %.1f sets/s\n",
+           list.count, *failed, ms, ms > 0 ? list.count * 1000.0 / ms : 0.0);
+    free(sets);
+    path_list_free(&list);
+    return MAXTRI_OK;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "maxtri.h"
+
+// Пакетный режим: много наборов точек в одном процессе на общем пуле. Каждый набор — задача пула,
+// которая загружает его и ищет ответ: небольшой набор целиком в своём потоке, а начиная
+// с BATCH_PARALLEL_POINTS точек — на всех потоках пула.
+#define BATCH_PARALLEL_POINTS 2048
+
+// Сколько наборов на поток может быть в очереди сверх ещё не выведенных: очередь не растёт
+// на весь пакет, и подзадачи большого набора не ждут за тысячами маленьких
+#define BATCH_WINDOW_PER_THREAD 4
+
+// path — каталог (все обычные файлы, кроме скрытых, по имени) или список файлов по одному
+// в строке (пустые строки и строки с # пропускаются, относительные пути — от каталога списка).
+// Ответы печатаются в порядке наборов, в конце — число наборов в секунду. Настройки поиска
+// и пул берутся из opts, текстовые наборы разбираются в координаты размера text_scalar_size
+// (4 или 8). Возвращает MAXTRI_OK, если пакет удалось прочитать, иначе код ошибки;
+// ошибки отдельных наборов печатаются в их строках, а их число записывается в *failed.
+int batch_run(const char* path, const maxtri_opts* opts, int text_scalar_size, int* failed);
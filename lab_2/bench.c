@@ -0,0 +1,358 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <limits.h>
+#include <string.h>
+#include <getopt.h>
+#include "coordinates.h"
+#include "pool.h"
+#include "loader.h"
+#include "maxtri.h"
+#include "procs.h"
+
+// Замер libmaxtri: для каждого варианта поиска, числа точек и числа потоков делается несколько
+// прогревочных запусков и trials замеров. Ускорение считается относительно последовательного
+// варианта на тех же точках, эффективность — ускорение на поток.
+
+#define MAX_LIST 64
+
+// Первые четыре — maxtri_backend, за ними перебор в процессах (procs_find) с тем же ядром, что у threads
+static const char* const backend_names[] = {"sequential", "simd", "threads", "hull", "procs"};
+#define BACKEND_PROCS 4
+
+typedef struct {
+    const char* backend;
+    int n;
+    int threads;
+    int trials;
+    long long median_ns;
+    long long p95_ns;
+    double triples_per_sec;
+    double speedup;
+    double efficiency;
+    double area;
+} Row;
+
+// Список не больше cap чисел через запятую; возвращает их количество или -1
+static int parse_list(const char* text, int* out, int cap, int min) {
+    int count = 0;
+    const char* p = text;
+    while (*p != '\0') {
+        char* endptr;
+        long value = strtol(p, &endptr, 10);
+        if (endptr == p || value < min || value > INT_MAX || count == cap) {
+            return -1;
+        }
+        out[count++] = (int)value;
+        p = endptr;
+        if (*p == ',') {
+            ++p;
+        } else if (*p != '\0') {
+            return -1;
+        }
+    }
+    return count;
+}
+
+static int parse_backends(const char* text, int* out) {
+    int count = 0;
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", text);
+    for (char* name = strtok(buf, ","); name != NULL; name = strtok(NULL, ",")) {
+        int found = -1;
+        for (int b = 0; b < (int)(sizeof(backend_names) / sizeof(backend_names[0])); ++b) {
+            if (strcmp(name, backend_names[b]) == 0) {
+                found = b;
+            }
+        }
+        if (found < 0 || count == MAX_LIST) {
+            return -1;
+        }
+        out[count++] = found;
+    }
+    return count;
+}
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int cmp_ll(const void* a, const void* b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+// Замер одного сочетания (procs > 0 — в стольких процессах); возвращает MAXTRI_OK или код ошибки
+static int measure(const float* xyz, int n, maxtri_opts* opts, int procs, int warmup, int trials, long long* times,
+                   double* area) {
+    maxtri_result result;
+    int failed;
+    for (int t = 0; t < warmup + trials; ++t) {
+        long long start = now_ns();
+        int status = procs > 0 ? procs_find((const float (*)[3])xyz, n, procs, opts, &result, &failed)
+                               : maxtri_find(xyz, n, opts, &result);
+        long long elapsed = now_ns() - start;
+        if (status != MAXTRI_OK) {
+            return status;
+        }
+        *area = result.best.area;
+        maxtri_result_free(&result);
+        if (t >= warmup) {
+            times[t - warmup] = elapsed;
+        }
+    }
+    qsort(times, trials, sizeof(long long), cmp_ll);
+    return MAXTRI_OK;
+}
+
+static void print_rows(FILE* out, const Row* rows, int count, int json) {
+    if (json) {
+        fprintf(out, "[\n");
+        for (int r = 0; r < count; ++r) {
+            const Row* row = &rows[r];
+            fprintf(out, "  {\"backend\": \"%s\", \"n\": %d, \"threads\": %d, \"trials\": %d, "
+                    "\"median_ns\": %lld, \"p95_ns\": %lld, \"triples_per_sec\": %.6g, "
+                    "\"speedup\": %.4f, \"efficiency\": %.4f, \"area\": %.2f}%s\n",
+                    row->backend, row->n, row->threads, row->trials, row->median_ns, row->p95_ns,
+                    row->triples_per_sec, row->speedup, row->efficiency, row->area, r + 1 < count ? "," : "");
+        }
+        fprintf(out, "]\n");
+        return;
+    }
+    fprintf(out, "backend,n,threads,trials,median_ns,p95_ns,triples_per_sec,speedup,efficiency,area\n");
+    for (int r = 0; r < count; ++r) {
+        const Row* row = &rows[r];
+        fprintf(out, "%s,%d,%d,%d,%lld,%lld,%.6g,%.4f,%.4f,%.2f\n", row->backend, row->n, row->threads,
+                row->trials, row->median_ns, row->p95_ns, row->triples_per_sec, row->speedup,
+                row->efficiency, row->area);
+    }
+}
+
+static void usage(const char* prog) {
+    printf("Usage: %s [--threads 1,2,4] [--sizes 500,1000] [--backends sequential,simd,threads,hull,procs] "
+           "[--warmup n] [--trials n] [--format csv|json] [--input file] [--output file] [--pin none|compact|scatter]\n", prog);
+}
+
+int main(int argc, char* argv[]) {
+    int threads_list[MAX_LIST] = {1, 2, 4};
+    int threads_count = 3;
+    int sizes[MAX_LIST];
+    int sizes_count = 0;
+    int backends[MAX_LIST] = {0, 1, 2, 3, 4};
+    int backends_count = 5;
+    int warmup = 1, trials = 5;
+    int json = 0;
+    int pin = PIN_COMPACT;
+    const char* input = NULL;
+    const char* output = NULL;
+    static const struct option long_options[] = {
+        {"threads", required_argument, NULL, 't'},
+        {"sizes", required_argument, NULL, 'n'},
+        {"backends", required_argument, NULL, 'b'},
+        {"warmup", required_argument, NULL, 'w'},
+        {"trials", required_argument, NULL, 'r'},
+        {"format", required_argument, NULL, 'f'},
+        {"input", required_argument, NULL, 'i'},
+        {"output", required_argument, NULL, 'o'},
+        {"pin", required_argument, NULL, 'P'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    int single[1];
+    while ((opt = getopt_long(argc, argv, "t:n:b:w:r:f:i:o:P:", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 't':
+            threads_count = parse_list(optarg, threads_list, MAX_LIST, 1);
+            if (threads_count <= 0) {
+                printf("Thread counts must be a comma-separated list of positive integers\n");
+                return 1;
+            }
+            break;
+        case 'n':
+            sizes_count = parse_list(optarg, sizes, MAX_LIST, 3);
+            if (sizes_count <= 0) {
+                printf("Sizes must be a comma-separated list of integers not less than 3\n");
+                return 1;
+            }
+            break;
+        case 'b':
+            backends_count = parse_backends(optarg, backends);
+            if (backends_count <= 0) {
+                printf("Unknown backend in: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'w':
+            if (parse_list(optarg, single, 1, 0) != 1) {
+                printf("Warmup must be a non-negative integer\n");
+                return 1;
+            }
+            warmup = single[0];
+            break;
+        case 'r':
+            if (parse_list(optarg, single, 1, 1) != 1) {
+                printf("Trials must be a positive integer\n");
+                return 1;
+            }
+            trials = single[0];
+            break;
+        case 'f':
+            if (strcmp(optarg, "csv") != 0 && strcmp(optarg, "json") != 0) {
+                printf("Unknown format: %s\n", optarg);
+                return 1;
+            }
+            json = strcmp(optarg, "json") == 0;
+            break;
+        case 'i':
+            input = optarg;
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        case 'P':
+            pin = pool_parse_pin(optarg);
+            if (pin < 0) {
+                printf("Unknown pinning policy: %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind != argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    PointSet set = {coordinates, num_points, NULL, 0, NULL, 3, sizeof(float), coordinates};
+    if (input != NULL) {
+        const char* error = points_load(input, NULL, &set);
+        if (error != NULL) {
+            printf("Failed to load %s: %s\n", input, error);
+            return 1;
+        }
+        if (set.xyz == NULL) {
+            printf("Benchmark needs 3D float32 points: %s\n", input);
+            return 1;
+        }
+    }
+    if (sizes_count == 0) {
+        sizes[0] = set.n;
+        sizes_count = 1;
+    }
+    for (int s = 0; s < sizes_count; ++s) {
+        if (sizes[s] > set.n) {
+            printf("Number of points must be between 3 and %d\n", set.n);
+            return 1;
+        }
+    }
+
+    // Пулы создаются заранее и не входят в замер, как и в main
+    ThreadPool** pools = calloc(threads_count, sizeof(ThreadPool*));
+    for (int t = 0; t < threads_count; ++t) {
+        if (threads_list[t] > 1) {
+            pools[t] = pool_create(threads_list[t], threads_list[t], pin);
+            if (pools[t] == NULL) {
+                printf("Failed to create threads\n");
+                return 1;
+            }
+        }
+    }
+
+    Row* rows = malloc((size_t)sizes_count * backends_count * threads_count * sizeof(Row));
+    long long* times = malloc(trials * sizeof(long long));
+    long long* base_times = malloc(trials * sizeof(long long));
+    int row_count = 0;
+    int mismatch = 0;
+    for (int s = 0; s < sizes_count; ++s) {
+        int n = sizes[s];
+        const float* xyz = &set.xyz[0][0];
+        double triples = (double)n * (n - 1) * (n - 2) / 6;
+
+        // Основа для ускорения: последовательный вариант на тех же точках
+        maxtri_opts opts;
+        maxtri_opts_init(&opts, MAXTRI_SEQUENTIAL);
+        double base_area;
+        int status = measure(xyz, n, &opts, 0, warmup, trials, base_times, &base_area);
+        if (status != MAXTRI_OK) {
+            printf("Benchmark failed: %s\n", maxtri_strerror(status));
+            return 1;
+        }
+        long long base_ns = base_times[(trials - 1) / 2];
+
+        for (int b = 0; b < backends_count; ++b) {
+            int procs = backends[b] == BACKEND_PROCS;
+            maxtri_backend backend = procs ? MAXTRI_THREADS : (maxtri_backend)backends[b];
+            int multi = backend == MAXTRI_THREADS || backend == MAXTRI_HULL;
+            for (int t = 0; t < threads_count; ++t) {
+                // Однопоточные варианты замеряются один раз
+                if (!multi && t > 0) {
+                    break;
+                }
+                int threads = multi ? threads_list[t] : 1;
+                maxtri_opts_init(&opts, backend);
+                opts.threads = threads;
+                // Процессы-работники однопоточные, пул им не нужен
+                opts.pool = multi && !procs ? pools[t] : NULL;
+                double area = base_area;
+                if (backend == MAXTRI_SEQUENTIAL) {
+                    memcpy(times, base_times, trials * sizeof(long long));
+                } else {
+                    status = measure(xyz, n, &opts, procs ? threads : 0, warmup, trials, times, &area);
+                }
+                if (status != MAXTRI_OK) {
+                    printf("Benchmark failed: %s\n", maxtri_strerror(status));
+                    return 1;
+                }
+                if (area != base_area) {
+                    fprintf(stderr, "Area mismatch: %s with %d threads on %d points gives %.2f instead of %.2f\n",
+                            backend_names[backends[b]], threads, n, area, base_area);
+                    mismatch = 1;
+                }
+                Row* row = &rows[row_count++];
+                row->backend = backend_names[backends[b]];
+                row->n = n;
+                row->threads = threads;
+                row->trials = trials;
+                row->median_ns = times[(trials - 1) / 2];
+                // Ближайший ранг: наименьшее время, не меньше которого 95% замеров
+                row->p95_ns = times[(95 * trials + 99) / 100 - 1];
+                row->triples_per_sec = triples / (row->median_ns > 0 ? row->median_ns : 1) * 1e9;
+                row->speedup = (double)base_ns / (row->median_ns > 0 ? row->median_ns : 1);
+                row->efficiency = row->speedup / threads;
+                row->area = area;
+            }
+        }
+    }
+
+    FILE* out = stdout;
+    if (output != NULL) {
+        out = fopen(output, "w");
+        if (out == NULL) {
+            printf("Failed to create %s\n", output);
+            return 1;
+        }
+    }
+    print_rows(out, rows, row_count, json);
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    for (int t = 0; t < threads_count; ++t) {
+        if (pools[t] != NULL) {
+            pool_destroy(pools[t]);
+        }
+    }
+    free(pools);
+    free(rows);
+    free(times);
+    free(base_times);
+    points_unload(&set);
+    return mismatch ? 2 : 0;
+}
@@ -0,0 +1,116 @@
+#include <math.h>
+#include <stdlib.h>
+#include "bound.h"
+
+// Сфера по центру ограничивающего параллелепипеда точек [begin, end)
+static Sphere enclose(const PointsSoA* ps, int begin, int end) {
+    double lo[3] = {ps->x[begin], ps->y[begin], ps->z[begin]};
+    double hi[3] = {lo[0], lo[1], lo[2]};
+    for (int p = begin + 1; p < end; ++p) {
+        double v[3] = {ps->x[p], ps->y[p], ps->z[p]};
+        for (int c = 0; c < 3; ++c) {
+            if (v[c] < lo[c]) lo[c] = v[c];
+            if (v[c] > hi[c]) hi[c] = v[c];
+        }
+    }
+    Sphere s = {(lo[0] + hi[0]) / 2, (lo[1] + hi[1]) / 2, (lo[2] + hi[2]) / 2, 0.0};
+    double r2 = 0.0;
+    for (int p = begin; p < end; ++p) {
+        double dx = ps->x[p] - s.x, dy = ps->y[p] - s.y, dz = ps->z[p] - s.z;
+        double d2 = dx * dx + dy * dy + dz * dz;
+        if (d2 > r2) r2 = d2;
+    }
+    s.r = sqrt(r2);
+    return s;
+}
+
+int bounds_init(Bounds* bounds, const PointsSoA* ps) {
+    int n = ps->n;
+    bounds->block_count = (n + BOUND_BLOCK - 1) / BOUND_BLOCK;
+    bounds->blocks = malloc((bounds->block_count + 1) * sizeof(Sphere));
+    bounds->reach2 = malloc((n + 1) * sizeof(double));
+    if (bounds->blocks == NULL || bounds->reach2 == NULL) {
+        bounds_free(bounds);
+        return -1;
+    }
+    if (n == 0) {
+        bounds->all = (Sphere){0.0, 0.0, 0.0, 0.0};
+        bounds->slack = 0.0;
+        return 0;
+    }
+    bounds->all = enclose(ps, 0, n);
+    for (int b = 0; b < bounds->block_count; ++b) {
+        int end = (b + 1) * BOUND_BLOCK < n ? (b + 1) * BOUND_BLOCK : n;
+        bounds->blocks[b] = enclose(ps, b * BOUND_BLOCK, end);
+    }
+    const Sphere* all = &bounds->all;
+    for (int p = 0; p < n; ++p) {
+        double dx = ps->x[p] - all->x, dy = ps->y[p] - all->y, dz = ps->z[p] - all->z;
+        double reach = sqrt(dx * dx + dy * dy + dz * dz) + all->r;
+        bounds->reach2[p] = reach * reach;
+    }
+    // Ядро считает квадрат с абсолютной ошибкой порядка 2^-20 |p_j - p_i|^2 |p_k - p_i|^2,
+    // а стороны не длиннее диаметра 2R
+    double d2 = 4.0 * all->r * all->r;
+    bounds->slack = 1e-5 * d2 * d2;
+    return 0;
+}
+
+void bounds_free(Bounds* bounds) {
+    free(bounds->blocks);
+    free(bounds->reach2);
+    bounds->blocks = NULL;
+    bounds->reach2 = NULL;
+    bounds->block_count = 0;
+}
+
+double bound_block(const Bounds* bounds, const PointsSoA* ps, int i, int j, double len2, int b) {
+    const Sphere* s = &bounds->blocks[b];
+    double ux = (double)ps->x[j] - ps->x[i], uy = (double)ps->y[j] - ps->y[i], uz = (double)ps->z[j] - ps->z[i];
+    double wx = s->x - ps->x[i], wy = s->y - ps->y[i], wz = s->z - ps->z[i];
+    double cx = wy * uz - wz * uy;
+    double cy = wz * ux - wx * uz;
+    double cz = wx * uy - wy * ux;
+    // |ij|^2 * (dist + r)^2, где dist = |w x u| / |u|
+    double cross = sqrt(cx * cx + cy * cy + cz * cz);
+    double len = sqrt(len2);
+    double h = cross + s->r * len;
+    return h * h;
+}
+
+static int farthest(const PointsSoA* ps, int from) {
+    double best = -1.0;
+    int best_p = from;
+    for (int p = 0; p < ps->n; ++p) {
+        double dx = (double)ps->x[p] - ps->x[from];
+        double dy = (double)ps->y[p] - ps->y[from];
+        double dz = (double)ps->z[p] - ps->z[from];
+        double d2 = dx * dx + dy * dy + dz * dz;
+        if (d2 > best) {
+            best = d2;
+            best_p = p;
+        }
+    }
+    return best_p;
+}
+
+float bounds_seed(const PointsSoA* ps, RowKernel kernel, int tri[3]) {
+    if (tri != NULL) {
+        tri[0] = tri[1] = tri[2] = -1;
+    }
+    if (ps->n < 3) {
+        return 0.0f;
+    }
+    int a = farthest(ps, 0);
+    int b = farthest(ps, a);
+    float best = 0.0f;
+    int k = -1;
+    kernel(ps, a, b, 0, ps->n, &best, &k);
+    if (tri != NULL && k >= 0) {
+        int lo = a < b ? a : b, hi = a < b ? b : a;
+        tri[0] = k < lo ? k : lo;
+        tri[1] = k < lo ? lo : (k < hi ? k : hi);
+        tri[2] = k > hi ? k : hi;
+    }
+    return best;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "kernel.h"
+
+// Число точек в блоке третьих вершин, для которого хранится описанная сфера
+#define BOUND_BLOCK 256
+
+typedef struct {
+    double x, y, z, r;
+} Sphere;
+
+// Оценки сверху квадрата нормы векторного произведения для отсечения перебора.
+// Все оценки считаются в double по исходным координатам; slack покрывает ошибку
+// округления, с которой ядро считает тот же квадрат во float.
+typedef struct {
+    Sphere all;         // сфера, содержащая все точки
+    Sphere* blocks;     // сферы блоков точек [b * BOUND_BLOCK, (b + 1) * BOUND_BLOCK)
+    int block_count;
+    double* reach2;     // (|p_i - центр| + R)^2: квадрат наибольшего расстояния от p_i до других точек
+    double slack;
+} Bounds;
+
+int bounds_init(Bounds* bounds, const PointsSoA* ps);
+void bounds_free(Bounds* bounds);
+
+// Оценка для всех треугольников с вершиной i: обе стороны из p_i не длиннее reach
+static inline double bound_row(const Bounds* bounds, int i) {
+    return bounds->reach2[i] * bounds->reach2[i];
+}
+
+// Оценка для пары (i, j) по длине стороны ij: высота к ней не больше reach от p_i
+static inline double bound_pair(const Bounds* bounds, int i, double len2) {
+    return len2 * bounds->reach2[i];
+}
+
+// Оценка для пары (i, j) и третьих вершин из блока b: |ij|^2 на квадрат наибольшего
+// расстояния точек блока до прямой ij (расстояние от центра сферы плюс её радиус)
+double bound_block(const Bounds* bounds, const PointsSoA* ps, int i, int j, double len2, int b);
+
+// Быстрый треугольник за O(n): самая дальняя от p_0 точка a, самая дальняя от a точка b
+// и самая дальняя от прямой ab точка. Возвращает его квадрат, посчитанный ядром; если tri != NULL,
+// туда записываются его вершины по возрастанию (-1 — все точки на одной прямой).
+float bounds_seed(const PointsSoA* ps, RowKernel kernel, int tri[3]);
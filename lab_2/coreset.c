@@ -0,0 +1,461 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "coreset.h"
+#include "approx.h"
+#include "loader.h"
+
+// Буфер текста: строка длиннее не разбирается
+#define CORESET_TEXT (1 << 20)
+
+static __thread char error_buf[96];
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define CORESET_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define CORESET_CLONES
+#endif
+
+// Единичные направления сетки и центр шара, по которому отбрасываются внутренние точки
+typedef struct {
+    int grid, directions;
+    double* u[3];       // координаты направлений, по directions
+    double* uc;         // скалярное произведение направления и центра
+    double c[3];
+    double c_norm;
+} Coreset;
+
+// Крайние точки одного потока; у каждого потока свои, они сводятся после прохода
+typedef struct {
+    double* best;       // наибольшее скалярное произведение по направлению
+    long long* index;   // номер крайней точки в файле; -1 — точек ещё не было
+    float (*point)[3];
+    double lo[3], hi[3];
+    double r2;          // квадрат расстояния от центра до самой дальней точки
+    // Квадрат радиуса шара вокруг центра внутри многогранника крайних точек: точка внутри него
+    // не больше крайней ни по одному направлению. -1 — шара ещё нет.
+    double inner2;
+} CoresetPart;
+
+typedef struct {
+    const Coreset* cs;
+    CoresetPart* part;
+    const float (*xyz)[3];
+    int count;
+    long long first;    // номер xyz[0] в файле
+} CoresetTask;
+
+typedef struct {
+    int fd;
+    int binary;
+    long long remaining;    // двоичный файл: точек до конца по заголовку
+    char* text;             // текст: [pos, len) ещё не разобрано
+    size_t pos, len;
+    int eof;
+    long long line;
+    const char* error;
+} Reader;
+
+static void part_inner(CoresetPart* part, const Coreset* cs) {
+    double r = DBL_MAX;
+    for (int d = 0; d < cs->directions; ++d) {
+        double gap = part->best[d] - cs->uc[d];
+        if (gap < r) r = gap;
+    }
+    // Запас на округление скалярных произведений: точка на границе шара перебирается
+    r -= 1e-9 * (fabs(r) + cs->c_norm);
+    part->inner2 = r > 0.0 ? r * r : -1.0;
+}
+
+// Обгоняет ли точка крайнюю хоть по одному направлению. Без ветвлений цикл векторизуется,
+// а у AVX2 нет FMA, поэтому значения совпадают с обычной версией побитово.
+CORESET_CLONES __attribute__((optimize("O3"))) static int coreset_beats(const Coreset* cs, const double* best,
+                                                                        const float* q) {
+    const double* ux = cs->u[0];
+    const double* uy = cs->u[1];
+    const double* uz = cs->u[2];
+    double qx = q[0], qy = q[1], qz = q[2];
+    long long beats = 0;
+    for (int d = 0; d < cs->directions; ++d) {
+        beats |= ux[d] * qx + uy[d] * qy + uz[d] * qz > best[d];
+    }
+    return beats != 0;
+}
+
+static void CoresetScan(void* arg) {
+    CoresetTask* task = (CoresetTask*) arg;
+    const Coreset* cs = task->cs;
+    CoresetPart* part = task->part;
+    const double* ux = cs->u[0];
+    const double* uy = cs->u[1];
+    const double* uz = cs->u[2];
+    for (int p = 0; p < task->count; ++p) {
+        const float* q = task->xyz[p];
+        double d2 = 0.0;
+        for (int c = 0; c < 3; ++c) {
+            if (q[c] < part->lo[c]) part->lo[c] = q[c];
+            if (q[c] > part->hi[c]) part->hi[c] = q[c];
+            double diff = q[c] - cs->c[c];
+            d2 += diff * diff;
+        }
+        if (d2 > part->r2) {
+            part->r2 = d2;
+        }
+        if (d2 < part->inner2) {
+            continue;
+        }
+        if (!coreset_beats(cs, part->best, q)) {
+            continue;
+        }
+        for (int d = 0; d < cs->directions; ++d) {
+            double value = ux[d] * q[0] + uy[d] * q[1] + uz[d] * q[2];
+            // Из равных остаётся точка с меньшим номером
+            if (value > part->best[d]) {
+                part->best[d] = value;
+                part->index[d] = task->first + p;
+                memcpy(part->point[d], q, sizeof(part->point[d]));
+            }
+        }
+        part_inner(part, cs);
+    }
+}
+
+static int read_full(int fd, char* buf, size_t size, size_t* got) {
+    *got = 0;
+    while (*got < size) {
+        ssize_t r = read(fd, buf + *got, size - *got);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) return -1;
+        if (r == 0) break;
+        *got += r;
+    }
+    return 0;
+}
+
+static int reader_open(Reader* r, const char* path) {
+    memset(r, 0, sizeof(Reader));
+    r->fd = open(path, O_RDONLY);
+    if (r->fd < 0) {
+        r->error = "failed to open file";
+        return -1;
+    }
+    posix_fadvise(r->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    PointsHeader header;
+    size_t got;
+    if (read_full(r->fd, (char*)&header, sizeof(header), &got) != 0) {
+        r->error = "failed to read file";
+        return -1;
+    }
+    if (got == sizeof(header) && memcmp(header.magic, POINTS_MAGIC, sizeof(header.magic)) == 0) {
+        if (header.version != POINTS_VERSION || header.dim != 3 || header.scalar_size != sizeof(float)) {
+            r->error = "only 3D float32 binary files are supported";
+            return -1;
+        }
+        r->binary = 1;
+        r->remaining = (long long)header.count;
+        return 0;
+    }
+    // Прочитанное начало текста остаётся в буфере
+    r->text = malloc(CORESET_TEXT);
+    if (r->text == NULL) {
+        r->error = "out of memory";
+        return -1;
+    }
+    memcpy(r->text, &header, got);
+    r->len = got;
+    r->eof = got < sizeof(header);
+    return 0;
+}
+
+static void reader_close(Reader* r) {
+    if (r->fd >= 0) {
+        close(r->fd);
+    }
+    free(r->text);
+}
+
+// Следующие не больше cap точек; 0 — конец файла, -1 — ошибка в r->error
+static int reader_next(Reader* r, float (*out)[3], int cap) {
+    if (r->binary) {
+        long long want = r->remaining < cap ? r->remaining : cap;
+        size_t got;
+        if (read_full(r->fd, (char*)out, want * sizeof(*out), &got) != 0) {
+            r->error = "failed to read file";
+            return -1;
+        }
+        if (got < want * sizeof(*out)) {
+            r->error = "file is shorter than its header";
+            return -1;
+        }
+        r->remaining -= want;
+        return (int)want;
+    }
+    int count = 0;
+    while (count < cap) {
+        char* begin = r->text + r->pos;
+        char* end = r->text + r->len;
+        char* eol = memchr(begin, '\n', end - begin);
+        if (eol == NULL && !r->eof) {
+            memmove(r->text, begin, end - begin);
+            r->len = end - begin;
+            r->pos = 0;
+            if (r->len == CORESET_TEXT) {
+                snprintf(error_buf, sizeof(error_buf), "line %lld is too long", r->line + 1);
+                r->error = error_buf;
+                return -1;
+            }
+            ssize_t got = read(r->fd, r->text + r->len, CORESET_TEXT - r->len);
+            if (got < 0 && errno == EINTR) continue;
+            if (got < 0) {
+                r->error = "failed to read file";
+                return -1;
+            }
+            r->len += got;
+            r->eof = got == 0;
+            continue;
+        }
+        if (eol == NULL) {
+            if (begin == end) break;
+            eol = end;
+        }
+        ++r->line;
+        int parsed = points_parse_line(begin, eol, out[count]);
+        // Первая строка может быть заголовком
+        if (parsed < 0 && r->line > 1) {
+            snprintf(error_buf, sizeof(error_buf), "invalid point at line %lld", r->line);
+            r->error = error_buf;
+            return -1;
+        }
+        count += parsed > 0;
+        r->pos = eol < end ? (size_t)(eol - r->text) + 1 : r->len;
+    }
+    return count;
+}
+
+typedef struct {
+    long long index;
+    const float* point;
+} CoresetEntry;
+
+static int cmp_entry(const void* a, const void* b) {
+    long long x = ((const CoresetEntry*)a)->index, y = ((const CoresetEntry*)b)->index;
+    return (x > y) - (x < y);
+}
+
+int coreset_run(const char* path, int grid, const maxtri_opts* opts, CoresetResult* out, const char** error) {
+    memset(out, 0, sizeof(CoresetResult));
+    out->i = out->j = out->k = -1;
+    out->ratio = 1.0;
+    *error = NULL;
+    if (grid < 1 || grid > 256) {
+        return MAXTRI_EINVAL;
+    }
+    Reader reader;
+    Reader* r = &reader;
+    if (reader_open(r, path) != 0) {
+        *error = r->error;
+        reader_close(r);
+        return MAXTRI_EINVAL;
+    }
+
+    Coreset cs = {grid, 6 * grid * grid, {NULL, NULL, NULL}, NULL, {0.0, 0.0, 0.0}, 0.0};
+    int D = cs.directions;
+    ThreadPool* pool = opts->pool;
+    int parts = pool ? pool_workers(pool) : 1;
+    CoresetPart* part = calloc(parts, sizeof(CoresetPart));
+    CoresetTask* tasks = calloc(parts, sizeof(CoresetTask));
+    float (*blocks[2])[3] = {malloc(CORESET_BLOCK * sizeof(float[3])), malloc(CORESET_BLOCK * sizeof(float[3]))};
+    // Пока точек не больше числа направлений, они хранятся все: память та же, а ответ точный
+    float (*all)[3] = malloc(D * sizeof(float[3]));
+    CoresetEntry* entries = malloc(D * sizeof(CoresetEntry));
+    float (*xyz)[3] = malloc(D * sizeof(float[3]));
+    long long* ids = malloc(D * sizeof(long long));
+    int status = MAXTRI_OK;
+    for (int c = 0; c < 3; ++c) {
+        cs.u[c] = malloc(D * sizeof(double));
+        if (cs.u[c] == NULL) status = MAXTRI_ENOMEM;
+    }
+    cs.uc = malloc(D * sizeof(double));
+    if (part == NULL || tasks == NULL || blocks[0] == NULL || blocks[1] == NULL || all == NULL || entries == NULL
+        || xyz == NULL || ids == NULL || cs.uc == NULL) {
+        status = MAXTRI_ENOMEM;
+    }
+    for (int t = 0; t < parts && status == MAXTRI_OK; ++t) {
+        part[t].best = malloc(D * sizeof(double));
+        part[t].index = malloc(D * sizeof(long long));
+        part[t].point = malloc(D * sizeof(float[3]));
+        if (part[t].best == NULL || part[t].index == NULL || part[t].point == NULL) {
+            status = MAXTRI_ENOMEM;
+            break;
+        }
+        for (int d = 0; d < D; ++d) {
+            part[t].best[d] = -DBL_MAX;
+            part[t].index[d] = -1;
+        }
+        for (int c = 0; c < 3; ++c) {
+            part[t].lo[c] = DBL_MAX;
+            part[t].hi[c] = -DBL_MAX;
+        }
+        part[t].inner2 = -1.0;
+    }
+    // Память под состояние не выделилась: это ошибка чтения файла, а не перебора
+    if (status == MAXTRI_ENOMEM) {
+        *error = "out of memory";
+    }
+    out->grid = grid;
+    out->directions = D;
+    out->memory = (size_t)parts * D * (sizeof(double) + sizeof(long long) + sizeof(float[3]))
+                + (size_t)D * (4 * sizeof(double) + 2 * sizeof(float[3]) + sizeof(CoresetEntry) + sizeof(long long))
+                + 2 * CORESET_BLOCK * sizeof(float[3]);
+
+    int cur = 0;
+    int count = status == MAXTRI_OK ? reader_next(r, blocks[cur], CORESET_BLOCK) : 0;
+    // Центр шара — середина рамки первой порции: внутренние точки отбрасываются относительно него
+    if (count > 0) {
+        double lo[3] = {DBL_MAX, DBL_MAX, DBL_MAX}, hi[3] = {-DBL_MAX, -DBL_MAX, -DBL_MAX};
+        for (int p = 0; p < count; ++p) {
+            for (int c = 0; c < 3; ++c) {
+                if (blocks[cur][p][c] < lo[c]) lo[c] = blocks[cur][p][c];
+                if (blocks[cur][p][c] > hi[c]) hi[c] = blocks[cur][p][c];
+            }
+        }
+        for (int c = 0; c < 3; ++c) {
+            cs.c[c] = (lo[c] + hi[c]) / 2;
+        }
+        cs.c_norm = sqrt(cs.c[0] * cs.c[0] + cs.c[1] * cs.c[1] + cs.c[2] * cs.c[2]);
+    }
+    for (int d = 0; d < D && status == MAXTRI_OK; ++d) {
+        double dir[3];
+        approx_direction(grid, d, dir);
+        double norm = sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+        cs.uc[d] = 0.0;
+        for (int c = 0; c < 3; ++c) {
+            cs.u[c][d] = dir[c] / norm;
+            cs.uc[d] += cs.u[c][d] * cs.c[c];
+        }
+    }
+
+    int exact = 1;
+    long long first = 0;
+    while (count > 0) {
+        TaskGroup group = {0};
+        for (int t = 0; t < parts; ++t) {
+            int begin = (int)((long long)count * t / parts), end = (int)((long long)count * (t + 1) / parts);
+            tasks[t] = (CoresetTask){&cs, &part[t], (const float (*)[3])blocks[cur] + begin, end - begin, first + begin};
+            if (parts > 1) {
+                pool_submit(pool, &group, CoresetScan, &tasks[t]);
+            } else {
+                CoresetScan(&tasks[t]);
+            }
+        }
+        // Следующая порция читается, пока потоки разбирают эту
+        int next = reader_next(r, blocks[cur ^ 1], CORESET_BLOCK);
+        if (exact && first + count <= D) {
+            memcpy(all[first], blocks[cur], count * sizeof(float[3]));
+        } else {
+            exact = 0;
+        }
+        if (parts > 1) {
+            pool_wait(pool, &group);
+        }
+        first += count;
+        cur ^= 1;
+        count = next;
+    }
+    if (count < 0) {
+        *error = r->error;
+        status = MAXTRI_EINVAL;
+    }
+    out->points = first;
+    out->exact = exact;
+
+    // Крайние точки потоков сводятся по направлениям, затем остаются различные по возрастанию номеров
+    int m = 0;
+    double r2 = 0.0, half_diag2 = 0.0;
+    if (status == MAXTRI_OK && exact) {
+        m = (int)first;
+        memcpy(xyz, all, m * sizeof(float[3]));
+        for (int p = 0; p < m; ++p) {
+            ids[p] = p;
+        }
+    } else if (status == MAXTRI_OK) {
+        for (int d = 0; d < D; ++d) {
+            int from = 0;
+            for (int t = 1; t < parts; ++t) {
+                if (part[t].index[d] >= 0 && (part[from].index[d] < 0 || part[t].best[d] > part[from].best[d]
+                    || (part[t].best[d] == part[from].best[d] && part[t].index[d] < part[from].index[d]))) {
+                    from = t;
+                }
+            }
+            entries[d] = (CoresetEntry){part[from].index[d], part[from].point[d]};
+        }
+        qsort(entries, D, sizeof(CoresetEntry), cmp_entry);
+        for (int d = 0; d < D; ++d) {
+            if (m == 0 || ids[m - 1] != entries[d].index) {
+                memcpy(xyz[m], entries[d].point, sizeof(xyz[m]));
+                ids[m++] = entries[d].index;
+            }
+        }
+        // Шар вокруг всех точек: вокруг центра или вокруг середины общей рамки, какой меньше
+        for (int c = 0; c < 3; ++c) {
+            double lo = DBL_MAX, hi = -DBL_MAX;
+            for (int t = 0; t < parts; ++t) {
+                if (part[t].lo[c] < lo) lo = part[t].lo[c];
+                if (part[t].hi[c] > hi) hi = part[t].hi[c];
+            }
+            half_diag2 += (hi - lo) * (hi - lo) / 4;
+        }
+        for (int t = 0; t < parts; ++t) {
+            if (part[t].r2 > r2) r2 = part[t].r2;
+        }
+        if (half_diag2 < r2) {
+            r2 = half_diag2;
+        }
+    }
+    out->size = m;
+
+    if (status == MAXTRI_OK && m >= 3) {
+        maxtri_result result;
+        status = maxtri_find(&xyz[0][0], m, opts, &result);
+        if (status == MAXTRI_OK) {
+            if (result.best.i >= 0) {
+                out->area = result.best.area;
+                out->i = ids[result.best.i];
+                out->j = ids[result.best.j];
+                out->k = ids[result.best.k];
+            }
+            maxtri_result_free(&result);
+        }
+    }
+    if (status == MAXTRI_OK && !exact) {
+        out->loss = approx_loss(r2, grid);
+        out->ratio = out->area > 0.0 ? out->area / (out->area + out->loss) : 0.0;
+    }
+
+    for (int t = 0; part != NULL && t < parts; ++t) {
+        free(part[t].best);
+        free(part[t].index);
+        free(part[t].point);
+    }
+    for (int c = 0; c < 3; ++c) {
+        free(cs.u[c]);
+    }
+    free(cs.uc);
+    free(ids);
+    free(xyz);
+    free(entries);
+    free(all);
+    free(blocks[0]);
+    free(blocks[1]);
+    free(tasks);
+    free(part);
+    reader_close(r);
+    return status;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "maxtri.h"
+
+// Поиск по файлу, который не помещается в память, за один проход. Для каждого из 6·g² направлений
+// сетки приближённого поиска (approx.h) хранится крайняя точка, а после прохода точный перебор
+// идёт только по этим точкам (ядру). Оптимум не больше найденной площади плюс approx_loss(R², g),
+// где R — радиус шара вокруг всех точек, поэтому гарантия известна без второго прохода.
+// Пока точек не больше 6·g², они хранятся целиком, и тогда ответ точный.
+
+// Точек в порции чтения: порция разбирается задачами пула, пока читается следующая
+#define CORESET_BLOCK (1 << 16)
+
+typedef struct {
+    long long points;       // прочитано точек
+    int grid;
+    int directions;         // 6·g²
+    int size;               // различных точек в ядре (или всех точек при точном ответе)
+    size_t memory;          // байт на состояние прохода: ядра потоков, запас для точного ответа, порции
+    int exact;              // 1 — все точки поместились и перебраны
+    double area;
+    long long i, j, k;      // номера точек в файле по возрастанию; -1 — треугольника нет
+    double loss;            // на сколько оптимум может быть больше area
+    double ratio;           // гарантированная доля от оптимума: area / (area + loss)
+} CoresetResult;
+
+// Читает точки из path (двоичный формат 3D float32 или текст по три числа в строке, как
+// в loader.h) и ищет треугольник по ядру сетки grid. Порции разбираются на opts->pool, ядро
+// перебирается maxtri_find с настройками opts. Ошибка чтения или нехватка памяти под состояние
+// записывается в *error.
+int coreset_run(const char* path, int grid, const maxtri_opts* opts, CoresetResult* out, const char** error);
@@ -0,0 +1,785 @@
+#define _GNU_SOURCE
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <math.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "dist.h"
+#include "engine.h"
+#include "hull.h"
+
+enum {
+    MSG_HELLO = 1,  // работник -> координатор: число потоков
+    MSG_POINTS,     // координатор -> работник: n, отсечение, tile_k (-1 — по кэшу), 3n координат
+    MSG_WORK,       // координатор -> работник: номер диапазона, число кусков, куски (i, j_begin, j_end)
+    MSG_RESULT,     // работник -> координатор: номер диапазона, квадрат, i, j, k
+    MSG_BOUND,      // в обе стороны: новый порог отсечения
+    MSG_STOP        // координатор -> работник: работа закончена
+};
+
+// Всего кусков и кусков в диапазоне на один поток работника: диапазон работника с большим
+// числом потоков длиннее, а десятки диапазонов на работника выравнивают время окончания
+#define DIST_CHUNKS 4096
+#define DIST_CHUNKS_PER_THREAD 16
+// Сколько диапазонов одновременно выдаётся работнику: один в работе, следующий уже в пути
+#define DIST_INFLIGHT 2
+// Наибольшее число точек в MSG_POINTS: перебор большего набора без оболочки всё равно не закончится,
+// а работник не выделяет память под размер, о котором сообщил собеседник, сверх этого
+#define DIST_MAX_POINTS (1 << 24)
+
+static uint32_t float_bits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float bits_float(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static int write_all(int fd, const void* buf, size_t size) {
+    const char* p = buf;
+    while (size > 0) {
+        ssize_t written = write(fd, p, size);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return -1;
+        p += written;
+        size -= written;
+    }
+    return 0;
+}
+
+static int read_all(int fd, void* buf, size_t size) {
+    char* p = buf;
+    while (size > 0) {
+        ssize_t got = read(fd, p, size);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return -1;
+        p += got;
+        size -= got;
+    }
+    return 0;
+}
+
+// Слова words уже в сетевом порядке. Заголовок и данные уходят одним вызовом: при двух
+// записях подряд алгоритм Нейгла задержал бы вторую до подтверждения первой
+static int send_raw(int fd, uint32_t type, const uint32_t* words, uint32_t count) {
+    uint32_t header[2] = {htonl(type), htonl(count)};
+    struct iovec iov[2] = {{header, sizeof(header)}, {(void*)words, count * sizeof(uint32_t)}};
+    ssize_t written;
+    do {
+        written = writev(fd, iov, count > 0 ? 2 : 1);
+    } while (written < 0 && errno == EINTR);
+    if (written < 0) {
+        return -1;
+    }
+    size_t total = sizeof(header) + count * sizeof(uint32_t);
+    if ((size_t)written == total) {
+        return 0;
+    }
+    // Короткая запись: дописать остаток по частям
+    if ((size_t)written < sizeof(header)) {
+        if (write_all(fd, (char*)header + written, sizeof(header) - written) != 0) {
+            return -1;
+        }
+        written = sizeof(header);
+    }
+    return write_all(fd, (const char*)words + (written - sizeof(header)), total - written);
+}
+
+// Сообщения короткие и ждут ответа, поэтому отправляются без задержки
+static void set_nodelay(int fd) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+static int send_msg(int fd, uint32_t type, const uint32_t* words, uint32_t count) {
+    uint32_t buf[8];
+    for (uint32_t w = 0; w < count; ++w) {
+        buf[w] = htonl(words[w]);
+    }
+    return send_raw(fd, type, buf, count);
+}
+
+// Читает сообщение целиком; слова в *words (буфер растёт по мере надобности) в порядке машины.
+// Сообщение длиннее max_count слов — ошибка: столько не бывает ни в одном ожидаемом сообщении
+static int recv_msg(int fd, uint32_t max_count, uint32_t* type, uint32_t** words, uint32_t* count, uint32_t* cap) {
+    uint32_t header[2];
+    if (read_all(fd, header, sizeof(header)) != 0) {
+        return -1;
+    }
+    *type = ntohl(header[0]);
+    *count = ntohl(header[1]);
+    if (*count > max_count) {
+        return -1;
+    }
+    if (*count > *cap) {
+        uint32_t* grown = realloc(*words, (size_t)*count * sizeof(uint32_t));
+        if (grown == NULL) {
+            return -1;
+        }
+        *words = grown;
+        *cap = *count;
+    }
+    if (*count > 0 && read_all(fd, *words, (size_t)*count * sizeof(uint32_t)) != 0) {
+        return -1;
+    }
+    for (uint32_t w = 0; w < *count; ++w) {
+        (*words)[w] = ntohl((*words)[w]);
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------- координатор
+
+typedef struct {
+    int begin, end;     // куски [begin, end) общего списка
+    int owner;          // номер работника, -1 — не выдан
+    int done;
+} Range;
+
+typedef struct {
+    int fd;
+    int threads;        // 0 — ещё не представился
+    int inflight;       // выдано и не возвращено диапазонов
+    char name[64];
+} Peer;
+
+typedef struct {
+    const Chunk* chunks;
+    int chunk_count;
+    int next_chunk;     // начало ещё не выданной части списка
+    Range* ranges;
+    int range_count, range_cap;
+    int* requeue;       // диапазоны отключившихся работников
+    int requeue_count;
+    int done_chunks;
+    Peer* peers;
+    int peer_count, peer_cap;
+    uint32_t* points;   // сообщение MSG_POINTS в сетевом порядке
+    uint32_t points_count;
+    int n;              // точек у работников
+    int no_memory;      // перебор прерван: не хватило памяти координатору
+    Triangle best;
+    float bound;        // разосланный порог: лучший квадрат, о котором известно координатору
+} Coordinator;
+
+static void peer_drop(Coordinator* c, int p) {
+    Peer* peer = &c->peers[p];
+    int lost = 0;
+    for (int r = 0; r < c->range_count; ++r) {
+        if (c->ranges[r].owner == p && !c->ranges[r].done) {
+            c->ranges[r].owner = -1;
+            c->requeue[c->requeue_count++] = r;
+            lost += c->ranges[r].end - c->ranges[r].begin;
+        }
+    }
+    printf("Worker %s disconnected, %d chunks reassigned\n", peer->name, lost);
+    fflush(stdout);
+    close(peer->fd);
+    peer->fd = -1;
+    peer->inflight = 0;
+}
+
+// Выдаёт работнику диапазоны, пока у него не станет DIST_INFLIGHT в работе
+static int peer_feed(Coordinator* c, int p) {
+    Peer* peer = &c->peers[p];
+    while (peer->inflight < DIST_INFLIGHT) {
+        int r;
+        if (c->requeue_count > 0) {
+            r = c->requeue[--c->requeue_count];
+        } else if (c->next_chunk < c->chunk_count) {
+            if (c->range_count == c->range_cap) {
+                Range* ranges = realloc(c->ranges, c->range_cap * 2 * sizeof(Range));
+                if (ranges != NULL) {
+                    c->ranges = ranges;
+                }
+                int* requeue = realloc(c->requeue, c->range_cap * 2 * sizeof(int));
+                if (requeue != NULL) {
+                    c->requeue = requeue;
+                }
+                if (ranges == NULL || requeue == NULL) {
+                    c->no_memory = 1;
+                    return 0;
+                }
+                c->range_cap *= 2;
+            }
+            r = c->range_count++;
+            int len = peer->threads * DIST_CHUNKS_PER_THREAD;
+            c->ranges[r].begin = c->next_chunk;
+            c->ranges[r].end = c->chunk_count - c->next_chunk > len ? c->next_chunk + len : c->chunk_count;
+            c->ranges[r].done = 0;
+            c->next_chunk = c->ranges[r].end;
+        } else {
+            return 0;
+        }
+        Range* range = &c->ranges[r];
+        int count = range->end - range->begin;
+        uint32_t* words = malloc((2 + 3 * (size_t)count) * sizeof(uint32_t));
+        if (words == NULL) {
+            c->requeue[c->requeue_count++] = r;
+            c->no_memory = 1;
+            return 0;
+        }
+        range->owner = p;
+        words[0] = htonl(r);
+        words[1] = htonl(count);
+        for (int k = 0; k < count; ++k) {
+            const Chunk* chunk = &c->chunks[range->begin + k];
+            words[2 + 3 * k] = htonl(chunk->i);
+            words[3 + 3 * k] = htonl(chunk->j_begin);
+            words[4 + 3 * k] = htonl(chunk->j_end);
+        }
+        int status = send_raw(peer->fd, MSG_WORK, words, 2 + 3 * count);
+        free(words);
+        ++peer->inflight;
+        if (status != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void broadcast_bound(Coordinator* c, int except) {
+    uint32_t bits = float_bits(c->bound);
+    for (int p = 0; p < c->peer_count; ++p) {
+        if (p != except && c->peers[p].fd >= 0 && c->peers[p].threads > 0) {
+            // Ошибка отправки обнаружится при следующем чтении
+            send_msg(c->peers[p].fd, MSG_BOUND, &bits, 1);
+        }
+    }
+}
+
+// Обрабатывает сообщение работника; -1 — работника нужно отключить
+static int peer_message(Coordinator* c, int p, uint32_t type, const uint32_t* words, uint32_t count) {
+    Peer* peer = &c->peers[p];
+    if (type == MSG_HELLO && count == 1 && peer->threads == 0) {
+        peer->threads = words[0] > 0 && words[0] < 65536 ? (int)words[0] : 1;
+        printf("Worker %s joined with %d threads\n", peer->name, peer->threads);
+        fflush(stdout);
+        if (send_raw(peer->fd, MSG_POINTS, c->points, c->points_count) != 0) {
+            return -1;
+        }
+        if (c->bound > 0.0f) {
+            uint32_t bits = float_bits(c->bound);
+            send_msg(peer->fd, MSG_BOUND, &bits, 1);
+        }
+        return peer_feed(c, p);
+    }
+    if (type == MSG_RESULT && count == 5 && words[0] < (uint32_t)c->range_count) {
+        Range* range = &c->ranges[words[0]];
+        Triangle t = {bits_float(words[1]), (int)words[2], (int)words[3], (int)words[4]};
+        // Треугольник либо не найден (все номера -1), либо его вершины среди точек работника;
+        // иначе диапазон не засчитывается и достанется другому
+        int found = t.i >= 0 && t.i < c->n && t.j >= 0 && t.j < c->n && t.k >= 0 && t.k < c->n;
+        int none = t.i == -1 && t.j == -1 && t.k == -1;
+        if (range->owner != p || range->done || !(found || none)) {
+            return -1;
+        }
+        range->done = 1;
+        --peer->inflight;
+        c->done_chunks += range->end - range->begin;
+        if (t.i >= 0 && (c->best.i < 0 || triangle_better(&t, &c->best))) {
+            c->best = t;
+        }
+        if (c->best.cross2 > c->bound) {
+            c->bound = c->best.cross2;
+            broadcast_bound(c, -1);
+        }
+        return peer_feed(c, p);
+    }
+    if (type == MSG_BOUND && count == 1) {
+        // Порог от работника — квадрат треугольника, который он уже нашёл
+        float value = bits_float(words[0]);
+        if (value > c->bound) {
+            c->bound = value;
+            broadcast_bound(c, p);
+        }
+        return 0;
+    }
+    return -1;
+}
+
+static int listen_on(const char* port) {
+    struct addrinfo hints = {0}, *res;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    if (getaddrinfo(NULL, port, &hints, &res) != 0) {
+        return -1;
+    }
+    int fd = -1;
+    for (struct addrinfo* ai = res; ai != NULL && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) != 0 || listen(fd, 16) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+int dist_coordinate(const char* port, const float (*xyz)[3], int n, const maxtri_opts* opts, maxtri_result* out,
+                    int* workers) {
+    memset(out, 0, sizeof(maxtri_result));
+    *workers = 0;
+    out->best.i = out->best.j = out->best.k = -1;
+    out->ratio = 1.0;
+    if (n < 3 || opts->top_k > 1 || opts->approx_eps > 0.0) {
+        return MAXTRI_EINVAL;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    // Работники получают уже отобранные точки, а номера переводятся обратно здесь
+    int* ids = NULL;
+    if (opts->backend == MAXTRI_HULL) {
+        ids = malloc(n * sizeof(int));
+        if (ids == NULL) {
+            return MAXTRI_ENOMEM;
+        }
+        n = hull_vertices_parallel(xyz, n, opts->pool, ids);
+        out->hull_count = n;
+    }
+    out->candidates = n;
+    if (n > DIST_MAX_POINTS) {
+        free(ids);
+        return MAXTRI_EINVAL;
+    }
+
+    int listen_fd = listen_on(port);
+    if (listen_fd < 0) {
+        free(ids);
+        return MAXTRI_ENET;
+    }
+
+    Coordinator c = {0};
+    Chunk* chunks = NULL;
+    c.chunk_count = schedule_build(n, DIST_CHUNKS, &chunks);
+    c.chunks = chunks;
+    c.range_cap = 64;
+    c.ranges = malloc(c.range_cap * sizeof(Range));
+    c.requeue = malloc(c.range_cap * sizeof(int));
+    c.peer_cap = 8;
+    c.peers = malloc(c.peer_cap * sizeof(Peer));
+    c.best = (Triangle){0.0f, -1, -1, -1};
+    c.bound = 0.0f;
+    c.n = n;
+    c.points_count = 3 + 3 * (uint32_t)n;
+    c.points = malloc(c.points_count * sizeof(uint32_t));
+    if (c.chunk_count < 0 || c.ranges == NULL || c.requeue == NULL || c.peers == NULL || c.points == NULL) {
+        close(listen_fd);
+        free(c.points);
+        free(c.peers);
+        free(c.requeue);
+        free(c.ranges);
+        free(chunks);
+        free(ids);
+        return MAXTRI_ENOMEM;
+    }
+    c.points[0] = htonl(n);
+    c.points[1] = htonl(opts->prune);
+    c.points[2] = htonl((uint32_t)opts->tile);
+    for (int p = 0; p < n; ++p) {
+        const float* point = xyz[ids ? ids[p] : p];
+        for (int d = 0; d < 3; ++d) {
+            c.points[3 + 3 * p + d] = htonl(float_bits(point[d]));
+        }
+    }
+
+    printf("Waiting for workers on port %s\n", port);
+    fflush(stdout);
+    uint32_t* words = NULL;
+    uint32_t words_cap = 0;
+    struct pollfd* fds = NULL;
+    while (c.done_chunks < c.chunk_count && !c.no_memory) {
+        struct pollfd* grown = realloc(fds, (c.peer_count + 1) * sizeof(struct pollfd));
+        if (grown == NULL) {
+            c.no_memory = 1;
+            break;
+        }
+        fds = grown;
+        fds[0].fd = listen_fd;
+        fds[0].events = POLLIN;
+        for (int p = 0; p < c.peer_count; ++p) {
+            fds[p + 1].fd = c.peers[p].fd;  // у отключённых -1, poll их пропускает
+            fds[p + 1].events = POLLIN;
+        }
+        if (poll(fds, c.peer_count + 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int p = 0; p < c.peer_count; ++p) {
+            if (c.peers[p].fd < 0 || fds[p + 1].revents == 0) {
+                continue;
+            }
+            uint32_t type, count;
+            if (recv_msg(c.peers[p].fd, 5, &type, &words, &count, &words_cap) != 0
+                || peer_message(&c, p, type, words, count) != 0) {
+                peer_drop(&c, p);
+            }
+        }
+        // Новый работник; диапазоны отключившихся достаются тем, у кого есть место
+        if (fds[0].revents & POLLIN) {
+            struct sockaddr_storage addr;
+            socklen_t len = sizeof(addr);
+            int fd = accept(listen_fd, (struct sockaddr*)&addr, &len);
+            if (fd >= 0 && c.peer_count == c.peer_cap) {
+                Peer* peers = realloc(c.peers, c.peer_cap * 2 * sizeof(Peer));
+                if (peers == NULL) {
+                    // Без места для работника он не принимается, остальные продолжают
+                    close(fd);
+                    fd = -1;
+                } else {
+                    c.peers = peers;
+                    c.peer_cap *= 2;
+                }
+            }
+            if (fd >= 0) {
+                Peer* peer = &c.peers[c.peer_count++];
+                memset(peer, 0, sizeof(Peer));
+                peer->fd = fd;
+                set_nodelay(fd);
+                char host[48] = "?", serv[16] = "?";
+                getnameinfo((struct sockaddr*)&addr, len, host, sizeof(host), serv, sizeof(serv),
+                            NI_NUMERICHOST | NI_NUMERICSERV);
+                snprintf(peer->name, sizeof(peer->name), "%s:%s", host, serv);
+            }
+        }
+        for (int p = 0; p < c.peer_count; ++p) {
+            if (c.peers[p].fd >= 0 && c.peers[p].threads > 0 && peer_feed(&c, p) != 0) {
+                peer_drop(&c, p);
+            }
+        }
+    }
+
+    for (int p = 0; p < c.peer_count; ++p) {
+        if (c.peers[p].fd >= 0) {
+            send_msg(c.peers[p].fd, MSG_STOP, NULL, 0);
+            close(c.peers[p].fd);
+        }
+        *workers += c.peers[p].threads > 0;
+    }
+    close(listen_fd);
+    int status = c.done_chunks == c.chunk_count ? MAXTRI_OK : c.no_memory ? MAXTRI_ENOMEM : MAXTRI_ENET;
+    if (status == MAXTRI_OK && c.best.i >= 0) {
+        out->best.area = 0.5 * sqrt(c.best.cross2);
+        out->best.i = ids ? ids[c.best.i] : c.best.i;
+        out->best.j = ids ? ids[c.best.j] : c.best.j;
+        out->best.k = ids ? ids[c.best.k] : c.best.k;
+    }
+    free(fds);
+    free(words);
+    free(c.points);
+    free(c.peers);
+    free(c.requeue);
+    free(c.ranges);
+    free(chunks);
+    free(ids);
+    return status;
+}
+
+// ---------------------------------------------------------------- работник
+
+typedef struct {
+    Engine* engine;
+    Chunk* chunks;
+    int count;
+    int tasks;
+    atomic_int next;
+    atomic_int finished;    // задач, закончивших диапазон
+    Scan* scans;            // по одному на задачу
+    int wake;               // последняя закончившая задача пишет сюда байт
+} WorkRange;
+
+typedef struct {
+    WorkRange* range;
+    int index;
+} WorkTask;
+
+static void WorkRangeTask(void* arg) {
+    WorkTask* task = (WorkTask*) arg;
+    WorkRange* range = task->range;
+    int c;
+    while ((c = atomic_fetch_add(&range->next, 1)) < range->count) {
+        engine_scan_chunk(range->engine, &range->chunks[c], &range->scans[task->index]);
+    }
+    if (atomic_fetch_add(&range->finished, 1) + 1 == range->tasks) {
+        char byte = 1;
+        while (write(range->wake, &byte, 1) < 0 && errno == EINTR) {}
+    }
+}
+
+static int connect_to(const char* address) {
+    char host[256];
+    snprintf(host, sizeof(host), "%s", address);
+    char* colon = strrchr(host, ':');
+    if (colon == NULL) {
+        return -1;
+    }
+    *colon = '\0';
+    struct addrinfo hints = {0}, *res;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, colon + 1, &hints, &res) != 0) {
+        return -1;
+    }
+    int fd = -1;
+    for (struct addrinfo* ai = res; ai != NULL && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    if (fd >= 0) {
+        set_nodelay(fd);
+    }
+    return fd;
+}
+
+// Полученный и ещё не начатый диапазон
+typedef struct {
+    int id;
+    Chunk* chunks;
+    int count;
+} QueuedRange;
+
+// Пока задачи перебирают диапазон, работник раз в DIST_BOUND_MS мс сообщает координатору свой порог
+#define DIST_BOUND_MS 20
+
+int dist_work(const char* address, const maxtri_opts* opts) {
+    signal(SIGPIPE, SIG_IGN);
+    EngineConfig config;
+    config.row_kernel = kernel_get(opts->kernel);
+    config.norm_kernel = kernel_norms_get(opts->kernel);
+    if (config.row_kernel == NULL || config.norm_kernel == NULL) {
+        return MAXTRI_EKERNEL;
+    }
+    ThreadPool* pool = opts->pool;
+    int threads = pool ? pool_workers(pool) : 1;
+
+    int fd = connect_to(address);
+    if (fd < 0) {
+        return MAXTRI_ENET;
+    }
+    uint32_t hello = threads;
+    uint32_t* words = NULL;
+    uint32_t words_cap = 0, type, count;
+    if (send_msg(fd, MSG_HELLO, &hello, 1) != 0
+        || recv_msg(fd, 3 + 3 * DIST_MAX_POINTS, &type, &words, &count, &words_cap) != 0
+        || type != MSG_POINTS || count < 3 || words[0] < 3 || words[0] > DIST_MAX_POINTS || count != 3 + 3 * words[0]) {
+        close(fd);
+        free(words);
+        return MAXTRI_ENET;
+    }
+    int n = (int)words[0];
+    config.prune = (int)words[1];
+    kernel_tile_sizes(&config.tile_j, &config.tile_k);
+    if ((int)words[2] >= 0) {
+        config.tile_k = (int)words[2];
+    }
+    config.top_k = 1;
+    // Слова уже в порядке машины, остаётся прочитать их биты как float; engine_init копирует точки
+    Engine engine;
+    int wake[2];
+    if (pipe(wake) != 0) {
+        close(fd);
+        free(words);
+        return MAXTRI_ETHREAD;
+    }
+    if (engine_init(&engine, (const float (*)[3])(words + 3), NULL, n, &config) != 0) {
+        close(wake[0]);
+        close(wake[1]);
+        close(fd);
+        free(words);
+        return MAXTRI_ENOMEM;
+    }
+
+    WorkRange range = {0};
+    range.engine = &engine;
+    range.tasks = threads;
+    range.wake = wake[1];
+    range.scans = calloc(threads, sizeof(Scan));
+    WorkTask* tasks = malloc(threads * sizeof(WorkTask));
+    int scans_ok = range.scans != NULL && tasks != NULL;
+    for (int t = 0; scans_ok && t < threads; ++t) {
+        scans_ok = scan_init(&range.scans[t], &engine) == 0;
+        tasks[t].range = &range;
+        tasks[t].index = t;
+    }
+    if (!scans_ok) {
+        for (int t = 0; range.scans != NULL && t < threads; ++t) {
+            scan_free(&range.scans[t]);
+        }
+        free(range.scans);
+        free(tasks);
+        engine_free(&engine);
+        close(wake[0]);
+        close(wake[1]);
+        close(fd);
+        free(words);
+        return MAXTRI_ENOMEM;
+    }
+    QueuedRange* queue = NULL;
+    int queue_len = 0, queue_cap = 0;
+    int active = -1;            // номер диапазона в работе
+    float sent_bound = engine_bound(&engine);
+    int status = MAXTRI_OK;
+
+    for (;;) {
+        if (active < 0 && queue_len > 0) {
+            active = queue[0].id;
+            range.chunks = queue[0].chunks;
+            range.count = queue[0].count;
+            memmove(queue, queue + 1, --queue_len * sizeof(QueuedRange));
+            // У каждого диапазона свой итог, поэтому лучшие треугольники потоков начинаются заново
+            for (int t = 0; t < threads; ++t) {
+                range.scans[t].best = 0.0f;
+                range.scans[t].i = range.scans[t].j = range.scans[t].k = -1;
+            }
+            atomic_store(&range.next, 0);
+            atomic_store(&range.finished, 0);
+            if (pool) {
+                for (int t = 0; t < threads; ++t) {
+                    pool_submit(pool, NULL, WorkRangeTask, &tasks[t]);
+                }
+            } else {
+                WorkRangeTask(&tasks[0]);
+            }
+        }
+
+        struct pollfd fds[2] = {{fd, POLLIN, 0}, {wake[0], POLLIN, 0}};
+        if (poll(fds, 2, active >= 0 ? DIST_BOUND_MS : -1) < 0) {
+            if (errno == EINTR) continue;
+            status = MAXTRI_ENET;
+            break;
+        }
+
+        // Свой улучшенный порог координатор разошлёт остальным
+        float bound = engine_bound(&engine);
+        if (bound > sent_bound) {
+            uint32_t bits = float_bits(bound);
+            send_msg(fd, MSG_BOUND, &bits, 1);
+            sent_bound = bound;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            char byte;
+            while (read(wake[0], &byte, 1) < 0 && errno == EINTR) {}
+            Scan total;
+            if (scan_init(&total, &engine) != 0) {
+                // Диапазон уже пройден, и задачи пула его не держат
+                free(range.chunks);
+                active = -1;
+                status = MAXTRI_ENOMEM;
+                break;
+            }
+            for (int t = 0; t < threads; ++t) {
+                scan_merge(&total, &range.scans[t]);
+            }
+            uint32_t result[5] = {(uint32_t)active, float_bits(total.best), (uint32_t)total.i,
+                                  (uint32_t)total.j, (uint32_t)total.k};
+            scan_free(&total);
+            free(range.chunks);
+            active = -1;
+            if (send_msg(fd, MSG_RESULT, result, 5) != 0) {
+                status = MAXTRI_ENET;
+                break;
+            }
+        }
+
+        if (fds[0].revents == 0) {
+            continue;
+        }
+        // Диапазон не длиннее того, что координатор выдаёт на заявленное число потоков
+        if (recv_msg(fd, 2 + 3 * (uint32_t)threads * DIST_CHUNKS_PER_THREAD, &type, &words, &count, &words_cap) != 0) {
+            status = MAXTRI_ENET;
+            break;
+        }
+        if (type == MSG_STOP) {
+            break;
+        } else if (type == MSG_BOUND && count == 1) {
+            engine_raise_bound(&engine, bits_float(words[0]));
+        } else if (type == MSG_WORK && count >= 2 && (count - 2) % 3 == 0 && words[1] == (count - 2) / 3) {
+            if (queue_len == queue_cap) {
+                int grown_cap = queue_cap ? queue_cap * 2 : 4;
+                QueuedRange* grown = realloc(queue, grown_cap * sizeof(QueuedRange));
+                if (grown == NULL) {
+                    status = MAXTRI_ENOMEM;
+                    break;
+                }
+                queue = grown;
+                queue_cap = grown_cap;
+            }
+            int chunk_count = (int)words[1];
+            Chunk* chunks = malloc((chunk_count > 0 ? chunk_count : 1) * sizeof(Chunk));
+            if (chunks == NULL) {
+                status = MAXTRI_ENOMEM;
+                break;
+            }
+            // Кусок перебирает тройки i < j < k с j из [j_begin, j_end): номера за пределами [0, n)
+            // означают испорченное сообщение, и связь с таким координатором обрывается
+            int valid = 1;
+            for (int k = 0; k < chunk_count; ++k) {
+                Chunk* chunk = &chunks[k];
+                chunk->i = (int)words[2 + 3 * k];
+                chunk->j_begin = (int)words[3 + 3 * k];
+                chunk->j_end = (int)words[4 + 3 * k];
+                if (chunk->i < 0 || chunk->j_begin <= chunk->i || chunk->j_end < chunk->j_begin || chunk->j_end > n) {
+                    valid = 0;
+                }
+            }
+            if (!valid) {
+                free(chunks);
+                status = MAXTRI_ENET;
+                break;
+            }
+            queue[queue_len++] = (QueuedRange){(int)words[0], chunks, chunk_count};
+        } else {
+            status = MAXTRI_ENET;
+            break;
+        }
+    }
+
+    // При обрыве связи задачи пула ещё могут перебирать диапазон
+    if (active >= 0) {
+        while (atomic_load(&range.finished) != threads) {
+            usleep(1000);
+        }
+        free(range.chunks);
+    }
+    for (int q = 0; q < queue_len; ++q) {
+        free(queue[q].chunks);
+    }
+    free(queue);
+    for (int t = 0; t < threads; ++t) {
+        scan_free(&range.scans[t]);
+    }
+    free(range.scans);
+    free(tasks);
+    engine_free(&engine);
+    close(wake[0]);
+    close(wake[1]);
+    free(words);
+    close(fd);
+    return status;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "maxtri.h"
+
+// Перебор на нескольких машинах. Координатор разбивает пары (i, j) на куски, выдаёт работникам
+// диапазоны кусков пропорционально их числу потоков и сводит частичные результаты. Диапазоны
+// отключившегося работника выдаются заново, а улучшенный порог отсечения рассылается всем.
+//
+// Сообщения по TCP: заголовок из двух 32-битных слов (тип, число слов) и слова данных,
+// всё в сетевом порядке байтов; float передаётся битами.
+
+// Координатор: слушает port, раздаёт работникам точки xyz и куски перебора, пока все куски
+// не будут перебраны. С MAXTRI_HULL перед раздачей строит оболочку на opts->pool.
+// В workers записывается число подключавшихся работников. --top и приближённый поиск не поддерживаются.
+int dist_coordinate(const char* port, const float (*xyz)[3], int n, const maxtri_opts* opts, maxtri_result* out,
+                    int* workers);
+
+// Работник: подключается к координатору по адресу "host:port" и перебирает выданные куски
+// на opts->pool (или в своём потоке, если пула нет), пока координатор не скажет закончить.
+int dist_work(const char* address, const maxtri_opts* opts);
@@ -0,0 +1,513 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "engine.h"
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int engine_init(Engine* engine, const float (*xyz)[3], const int* ids, int n, const EngineConfig* config) {
+    memset(engine, 0, sizeof(Engine));
+    engine->config = *config;
+    atomic_init(&engine->shared_best, 0u);
+    atomic_init(&engine->next_chunk, 0);
+    atomic_init(&engine->stop, 0);
+    atomic_init(&engine->done_cost, 0);
+    atomic_init(&engine->next_progress_ns, 0);
+    if (points_soa_init(&engine->points, xyz, ids, n) != 0) {
+        return -1;
+    }
+    if (config->prune) {
+        if (bounds_init(&engine->bounds, &engine->points) != 0) {
+            points_soa_free(&engine->points);
+            return -1;
+        }
+        // Быстрый треугольник сразу даёт порог, с которым большая часть пар отсекается.
+        // Для K лучших одного треугольника мало, и порог появляется по ходу перебора.
+        if (config->top_k == 1) {
+            engine_raise_bound(engine, bounds_seed(&engine->points, config->row_kernel, NULL));
+        }
+    }
+    return 0;
+}
+
+void engine_free(Engine* engine) {
+    points_soa_free(&engine->points);
+    bounds_free(&engine->bounds);
+    free(engine->chunks);
+    engine->chunks = NULL;
+    engine->chunk_count = 0;
+}
+
+int scan_init(Scan* scan, const Engine* engine) {
+    memset(scan, 0, sizeof(Scan));
+    scan->i = scan->j = scan->k = -1;
+    if (engine->config.top_k > 1) {
+        scan->norms = malloc(BOUND_BLOCK * sizeof(float));
+        if (topk_init(&scan->top, engine->config.top_k) != 0 || scan->norms == NULL) {
+            scan_free(scan);
+            return -1;
+        }
+    } else {
+        scan->row_best = malloc((engine->config.tile_j + 1) * sizeof(float));
+        scan->row_k = malloc((engine->config.tile_j + 1) * sizeof(int));
+        if (scan->row_best == NULL || scan->row_k == NULL) {
+            scan_free(scan);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void scan_free(Scan* scan) {
+    topk_free(&scan->top);
+    free(scan->row_best);
+    free(scan->row_k);
+    free(scan->norms);
+    scan->row_best = NULL;
+    scan->row_k = NULL;
+    scan->norms = NULL;
+}
+
+float engine_bound(Engine* engine) {
+    unsigned bits = atomic_load_explicit(&engine->shared_best, memory_order_relaxed);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void engine_raise_bound(Engine* engine, float value) {
+    unsigned bits;
+    memcpy(&bits, &value, sizeof(bits));
+    unsigned old = atomic_load_explicit(&engine->shared_best, memory_order_relaxed);
+    while (old < bits && !atomic_compare_exchange_weak_explicit(&engine->shared_best, &old, bits,
+                                                                memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+// Отбрасывается только то, что строго хуже с запасом на округление,
+// поэтому треугольники с равной лучшей площадью не теряются
+static int pruned(Engine* engine, double bound, float best) {
+    float shared = engine_bound(engine);
+    return bound + engine->bounds.slack < (shared > best ? shared : best);
+}
+
+static double pair_len2(const PointsSoA* ps, int i, int j) {
+    double dx = (double)ps->x[j] - ps->x[i];
+    double dy = (double)ps->y[j] - ps->y[i];
+    double dz = (double)ps->z[j] - ps->z[i];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// Перебор третьих вершин из [k_begin, k_end) для пары (i, j) без блоков, которые не могут дать лучше
+static void scan_pair(Engine* engine, int i, int j, int k_begin, int k_end, float* best, int* best_k,
+                      long long* triples) {
+    const PointsSoA* ps = &engine->points;
+    RowKernel kernel = engine->config.row_kernel;
+    if (k_begin < engine->fresh) {
+        k_begin = engine->fresh;
+    }
+    if (k_begin >= k_end) {
+        return;
+    }
+    if (!engine->config.prune) {
+        kernel(ps, i, j, k_begin, k_end, best, best_k);
+        *triples += k_end - k_begin;
+        return;
+    }
+    double len2 = pair_len2(ps, i, j);
+    if (pruned(engine, bound_pair(&engine->bounds, i, len2), *best)) {
+        return;
+    }
+    // Подряд идущие оставшиеся блоки передаются ядру одним отрезком
+    int run = -1;
+    for (int b = k_begin / BOUND_BLOCK; b * BOUND_BLOCK < k_end; ++b) {
+        int from = b * BOUND_BLOCK > k_begin ? b * BOUND_BLOCK : k_begin;
+        if (!pruned(engine, bound_block(&engine->bounds, ps, i, j, len2, b), *best)) {
+            if (run < 0) run = from;
+        } else if (run >= 0) {
+            kernel(ps, i, j, run, from, best, best_k);
+            *triples += from - run;
+            run = -1;
+        }
+    }
+    if (run >= 0) {
+        kernel(ps, i, j, run, k_end, best, best_k);
+        *triples += k_end - run;
+    }
+}
+
+// Перебор куска с обновлением лучшего квадрата.
+// Блок третьих вершин проходит по всем j блока пар, поэтому лучший k копится для каждого j
+// отдельно (row_best, row_k), а итоги j сравниваются по порядку, и при равных площадях
+// остаются те же номера, что и при обходе без блоков.
+static void scan_chunk_best(Engine* engine, const Chunk* chunk, Scan* scan) {
+    int n = engine->points.n;
+    int i = chunk->i;
+    int tile_j = engine->config.tile_j, tile_k = engine->config.tile_k;
+    if (engine->config.prune && pruned(engine, bound_row(&engine->bounds, i), scan->best)) {
+        return;
+    }
+    if (tile_k == 0 || n - chunk->j_begin - 1 <= tile_k) {
+        for (int j = chunk->j_begin; j < chunk->j_end; ++j) {
+            int k = -1;
+            scan_pair(engine, i, j, j + 1, n, &scan->best, &k, &scan->triples);
+            if (k >= 0) {
+                scan->i = i;
+                scan->j = j;
+                scan->k = k;
+            }
+        }
+    } else {
+        float* row_best = scan->row_best;
+        int* row_k = scan->row_k;
+        for (int jb = chunk->j_begin; jb < chunk->j_end; jb += tile_j) {
+            int je = jb + tile_j < chunk->j_end ? jb + tile_j : chunk->j_end;
+            for (int j = jb; j < je; ++j) {
+                row_best[j - jb] = scan->best;
+                row_k[j - jb] = -1;
+            }
+            int k_first = jb + 1 > engine->fresh ? jb + 1 : engine->fresh;
+            for (int kb = k_first; kb < n; kb += tile_k) {
+                int ke = kb + tile_k < n ? kb + tile_k : n;
+                for (int j = jb; j < je && j + 1 < ke; ++j) {
+                    int from = j + 1 > kb ? j + 1 : kb;
+                    scan_pair(engine, i, j, from, ke, &row_best[j - jb], &row_k[j - jb], &scan->triples);
+                }
+            }
+            for (int j = jb; j < je; ++j) {
+                if (row_k[j - jb] >= 0 && row_best[j - jb] > scan->best) {
+                    scan->best = row_best[j - jb];
+                    scan->i = i;
+                    scan->j = j;
+                    scan->k = row_k[j - jb];
+                }
+            }
+        }
+    }
+    // Порог нужен и снимкам хода перебора
+    if (engine->config.prune || engine->progress != NULL) {
+        engine_raise_bound(engine, scan->best);
+    }
+}
+
+// K лучших: ядро без отбора выдаёт квадраты блока третьих вершин, и в кучу потока попадают те,
+// что не хуже её K-го треугольника. Порогом отсечения служит K-й квадрат: в куче любого потока
+// уже есть K треугольников не хуже него.
+static void scan_pair_top(Engine* engine, int i, int j, int k_begin, int k_end, Scan* scan) {
+    const PointsSoA* ps = &engine->points;
+    TopK* heap = &scan->top;
+    int prune = engine->config.prune;
+    if (k_begin < engine->fresh) {
+        k_begin = engine->fresh;
+    }
+    if (k_begin >= k_end) {
+        return;
+    }
+    double len2 = pair_len2(ps, i, j);
+    if (prune && pruned(engine, bound_pair(&engine->bounds, i, len2), topk_threshold(heap))) {
+        return;
+    }
+    for (int b = k_begin / BOUND_BLOCK; b * BOUND_BLOCK < k_end; ++b) {
+        int from = b * BOUND_BLOCK > k_begin ? b * BOUND_BLOCK : k_begin;
+        int to = (b + 1) * BOUND_BLOCK < k_end ? (b + 1) * BOUND_BLOCK : k_end;
+        if (prune && pruned(engine, bound_block(&engine->bounds, ps, i, j, len2, b), topk_threshold(heap))) {
+            continue;
+        }
+        engine->config.norm_kernel(ps, i, j, from, to, scan->norms);
+        scan->triples += to - from;
+        float threshold = topk_threshold(heap);
+        for (int k = from; k < to; ++k) {
+            if (scan->norms[k - from] >= threshold) {
+                Triangle t = {scan->norms[k - from], i, j, k};
+                topk_push(heap, &t);
+                threshold = topk_threshold(heap);
+            }
+        }
+    }
+}
+
+// Порядок обхода тот же, что в scan_chunk_best; от порядка добавления набор K лучших не зависит
+static void scan_chunk_top(Engine* engine, const Chunk* chunk, Scan* scan) {
+    int n = engine->points.n;
+    int i = chunk->i;
+    int tile_j = engine->config.tile_j, tile_k = engine->config.tile_k;
+    TopK* heap = &scan->top;
+    if (engine->config.prune && pruned(engine, bound_row(&engine->bounds, i), topk_threshold(heap))) {
+        return;
+    }
+    int tile = tile_k == 0 || n - chunk->j_begin - 1 <= tile_k ? n : tile_k;
+    for (int jb = chunk->j_begin; jb < chunk->j_end; jb += tile_j) {
+        int je = jb + tile_j < chunk->j_end ? jb + tile_j : chunk->j_end;
+        int k_first = jb + 1 > engine->fresh ? jb + 1 : engine->fresh;
+        for (int kb = k_first; kb < n; kb += tile) {
+            int ke = kb + tile < n ? kb + tile : n;
+            for (int j = jb; j < je && j + 1 < ke; ++j) {
+                scan_pair_top(engine, i, j, j + 1 > kb ? j + 1 : kb, ke, scan);
+            }
+        }
+    }
+    if ((engine->config.prune || engine->progress != NULL) && heap->count == heap->cap) {
+        engine_raise_bound(engine, topk_threshold(heap));
+    }
+}
+
+void engine_scan_chunk(Engine* engine, const Chunk* chunk, Scan* scan) {
+    if (engine->config.top_k > 1) {
+        scan_chunk_top(engine, chunk, scan);
+    } else {
+        scan_chunk_best(engine, chunk, scan);
+    }
+}
+
+void scan_merge(Scan* into, const Scan* from) {
+    into->triples += from->triples;
+    if (from->top.count > 0) {
+        topk_merge(&into->top, &from->top);
+    }
+    if (from->i < 0) {
+        return;
+    }
+    Triangle a = {from->best, from->i, from->j, from->k};
+    Triangle b = {into->best, into->i, into->j, into->k};
+    if (into->i < 0 || triangle_better(&a, &b)) {
+        into->best = from->best;
+        into->i = from->i;
+        into->j = from->j;
+        into->k = from->k;
+    }
+}
+
+typedef struct {
+    Engine* engine;
+    Scan scan;
+    PerfSample* perf;   // NULL — без счётчиков
+} EngineTask;
+
+// Остановлен ли перебор: флаг уже поднят или срок прошёл
+static int engine_stopped(Engine* engine) {
+    if (atomic_load_explicit(&engine->stop, memory_order_relaxed)) {
+        return 1;
+    }
+    if (engine->deadline_ns > 0 && now_ns() >= engine->deadline_ns) {
+        atomic_store_explicit(&engine->stop, 1, memory_order_relaxed);
+        return 1;
+    }
+    return 0;
+}
+
+// Учитывает пройденный кусок; снимок делает та задача, которой удалось сдвинуть время следующего
+static void chunk_done(Engine* engine, long long cost) {
+    long long done = atomic_fetch_add_explicit(&engine->done_cost, cost, memory_order_relaxed) + cost;
+    if (engine->progress == NULL) {
+        return;
+    }
+    long long now = now_ns();
+    long long next = atomic_load_explicit(&engine->next_progress_ns, memory_order_relaxed);
+    if (now >= next && atomic_compare_exchange_strong(&engine->next_progress_ns, &next, now + engine->progress_ns)) {
+        engine->progress(engine->progress_arg, engine_bound(engine), (double)done / engine->total_cost);
+    }
+}
+
+// Забирает куски из общей очереди, пока они не кончатся или перебор не остановят.
+// Ядро заменяет лучший треугольник только строго большим, поэтому при обходе не по порядку (i, j)
+// кусок ищет треугольники не хуже найденного, а из равных остаётся тот, у которого номера меньше.
+static void scan_queue(Engine* engine, Scan* scan) {
+    int reordered = engine->far_first && engine->config.top_k == 1;
+    int c;
+    while (!engine_stopped(engine) && (c = atomic_fetch_add(&engine->next_chunk, 1)) < engine->chunk_count) {
+        const Chunk* chunk = &engine->chunks[c];
+        if (reordered && scan->i >= 0) {
+            Triangle prev = {scan->best, scan->i, scan->j, scan->k};
+            scan->best = nextafterf(prev.cross2, 0.0f);
+            scan->i = -1;
+            engine_scan_chunk(engine, chunk, scan);
+            Triangle found = {scan->best, scan->i, scan->j, scan->k};
+            if (scan->i < 0 || triangle_better(&prev, &found)) {
+                scan->best = prev.cross2;
+                scan->i = prev.i;
+                scan->j = prev.j;
+                scan->k = prev.k;
+            }
+        } else {
+            engine_scan_chunk(engine, chunk, scan);
+        }
+        chunk_done(engine, chunk_cost(chunk, engine->points.n));
+    }
+}
+
+typedef struct {
+    double dist2;
+    int i;
+} FarRow;
+
+static int far_row_compare(const void* a, const void* b) {
+    const FarRow* ra = (const FarRow*)a;
+    const FarRow* rb = (const FarRow*)b;
+    if (ra->dist2 != rb->dist2) {
+        return ra->dist2 < rb->dist2 ? 1 : -1;
+    }
+    return (ra->i > rb->i) - (ra->i < rb->i);
+}
+
+// Переставляет строки кусков по убыванию расстояния точки i от центра масс;
+// куски одной строки остаются подряд по возрастанию j
+static int order_far_first(Engine* engine) {
+    const PointsSoA* ps = &engine->points;
+    int n = ps->n;
+    FarRow* rows = malloc(n * sizeof(FarRow));
+    int* first = malloc((n + 1) * sizeof(int));
+    Chunk* chunks = malloc((engine->chunk_count > 0 ? engine->chunk_count : 1) * sizeof(Chunk));
+    if (rows == NULL || first == NULL || chunks == NULL) {
+        free(rows);
+        free(first);
+        free(chunks);
+        return -1;
+    }
+    double cx = 0.0, cy = 0.0, cz = 0.0;
+    for (int p = 0; p < n; ++p) {
+        cx += ps->x[p];
+        cy += ps->y[p];
+        cz += ps->z[p];
+    }
+    cx /= n;
+    cy /= n;
+    cz /= n;
+    for (int p = 0; p < n; ++p) {
+        double dx = ps->x[p] - cx, dy = ps->y[p] - cy, dz = ps->z[p] - cz;
+        rows[p].dist2 = dx * dx + dy * dy + dz * dz;
+        rows[p].i = p;
+    }
+    qsort(rows, n, sizeof(FarRow), far_row_compare);
+    // schedule_build выдаёт строки по возрастанию i
+    int c = 0;
+    for (int i = 0; i < n; ++i) {
+        first[i] = c;
+        while (c < engine->chunk_count && engine->chunks[c].i == i) {
+            ++c;
+        }
+    }
+    first[n] = c;
+    int count = 0;
+    for (int r = 0; r < n; ++r) {
+        int i = rows[r].i;
+        for (int k = first[i]; k < first[i + 1]; ++k) {
+            chunks[count++] = engine->chunks[k];
+        }
+    }
+    free(engine->chunks);
+    engine->chunks = chunks;
+    free(rows);
+    free(first);
+    return 0;
+}
+
+double engine_coverage(Engine* engine) {
+    long long done = atomic_load(&engine->done_cost);
+    return engine->total_cost > 0 && done < engine->total_cost ? (double)done / engine->total_cost : 1.0;
+}
+
+static void EngineWorker(void* arg) {
+    EngineTask* task = (EngineTask*) arg;
+    Engine* engine = task->engine;
+    PerfCounters counters;
+    if (task->perf) {
+        perf_start(&counters);
+    }
+    scan_queue(engine, &task->scan);
+    if (task->perf) {
+        perf_stop(&counters, task->perf);
+        task->perf->triples += task->scan.triples;
+    }
+}
+
+int engine_run(Engine* engine, ThreadPool* pool, int threads, Scan* out) {
+    int n = engine->points.n;
+    engine->total_cost = (long long)n * (n - 1) * (n - 2) / 6;
+    atomic_store(&engine->done_cost, 0);
+    atomic_store(&engine->stop, 0);
+    atomic_store(&engine->next_progress_ns, now_ns() + engine->progress_ns);
+    if (pool == NULL || threads <= 1) {
+        // Со сроком или снимками строки делятся на куски, чтобы не ждать конца длинной строки
+        int queued = engine->deadline_ns > 0 || engine->progress != NULL || engine->far_first;
+        if (queued) {
+            free(engine->chunks);
+            engine->chunk_count = schedule_build(n, 1024, &engine->chunks);
+            if (engine->chunk_count < 0) {
+                engine->chunk_count = 0;
+                return -1;
+            }
+            if (engine->far_first && order_far_first(engine) != 0) {
+                return -1;
+            }
+            atomic_store(&engine->next_chunk, 0);
+        }
+        PerfCounters counters;
+        long long triples = out->triples;
+        if (engine->perf) {
+            perf_start(&counters);
+        }
+        if (queued) {
+            scan_queue(engine, out);
+        } else {
+            for (int i = 0; i < n - 2; ++i) {
+                Chunk row = {i, i + 1, n - 1};
+                engine_scan_chunk(engine, &row, out);
+                chunk_done(engine, chunk_cost(&row, n));
+            }
+        }
+        if (engine->perf) {
+            perf_stop(&counters, &engine->perf[0]);
+            engine->perf[0].triples += out->triples - triples;
+        }
+        return 0;
+    }
+
+    EngineTask* tasks = calloc(threads, sizeof(EngineTask));
+    if (tasks == NULL) {
+        return -1;
+    }
+    int ready = 0;
+    while (ready < threads && scan_init(&tasks[ready].scan, engine) == 0) {
+        tasks[ready].engine = engine;
+        tasks[ready].perf = engine->perf ? &engine->perf[ready] : NULL;
+        ++ready;
+    }
+    // По несколько десятков кусков на поток, чтобы потоки заканчивали почти одновременно;
+    // со сроком куски мельче, чтобы остановка не ждала конца длинного куска
+    free(engine->chunks);
+    engine->chunks = NULL;
+    long long per_thread = engine->deadline_ns > 0 ? 1024 : 64;
+    engine->chunk_count = ready == threads ? schedule_build(n, threads * per_thread, &engine->chunks) : -1;
+    if (engine->chunk_count >= 0 && engine->far_first && order_far_first(engine) != 0) {
+        engine->chunk_count = -1;
+    }
+    if (engine->chunk_count < 0) {
+        free(engine->chunks);
+        engine->chunks = NULL;
+        engine->chunk_count = 0;
+        for (int t = 0; t < ready; ++t) {
+            scan_free(&tasks[t].scan);
+        }
+        free(tasks);
+        return -1;
+    }
+    atomic_store(&engine->next_chunk, 0);
+    TaskGroup group = {0};
+    for (int t = 0; t < threads; ++t) {
+        pool_submit(pool, &group, EngineWorker, &tasks[t]);
+    }
+    pool_wait(pool, &group);
+    for (int t = 0; t < threads; ++t) {
+        scan_merge(out, &tasks[t].scan);
+        scan_free(&tasks[t].scan);
+    }
+    free(tasks);
+    return 0;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdatomic.h>
+#include "kernel.h"
+#include "schedule.h"
+#include "bound.h"
+#include "topk.h"
+#include "pool.h"
+#include "perf.h"
+
+// Снимок хода перебора: общий порог и доля пройденных троек
+typedef void (*EngineProgress)(void* arg, float bound, double coverage);
+
+// Настройки точного перебора
+typedef struct {
+    RowKernel row_kernel;
+    NormKernel norm_kernel;
+    // Блок из tile_k третьих вершин проходит по tile_j парам (i, j) и за это время
+    // не вытесняется из кэша. tile_k == 0 — обход без блоков.
+    int tile_j, tile_k;
+    int prune;          // отсекать пары и блоки по оценкам сверху
+    int top_k;          // сколько лучших треугольников искать
+} EngineConfig;
+
+// Точный перебор троек по копии точек в виде структуры массивов. Всё состояние перебора
+// хранится здесь, поэтому независимые переборы могут идти одновременно.
+typedef struct {
+    EngineConfig config;
+    PointsSoA points;
+    Bounds bounds;
+    // Лучший квадрат (при top_k > 1 — K-й лучший), найденный любым потоком. Хранятся биты float:
+    // у неотрицательных float порядок битов совпадает с порядком чисел.
+    atomic_uint shared_best;
+    // Общая очередь кусков: потоки по очереди забирают следующий кусок атомарным счётчиком
+    Chunk* chunks;
+    int chunk_count;
+    atomic_int next_chunk;
+    // Перебираются только тройки, у которых третья вершина k >= fresh (0 — все тройки).
+    // Если новые точки стоят в конце, остаются только тройки хотя бы с одной новой точкой.
+    int fresh;
+    // Счётчики задач engine_run: по одному PerfSample на поток (NULL — без счётчиков)
+    PerfSample* perf;
+    // Перебор к сроку: задачи проверяют stop перед каждым куском, а первая, заметившая, что
+    // deadline_ns (CLOCK_MONOTONIC) прошёл, поднимает его для остальных. 0 — без срока.
+    long long deadline_ns;
+    atomic_int stop;
+    // Куски строк с самыми дальними от центра точками i идут первыми: ранний ответ уже хороший
+    int far_first;
+    // Троек в пройденных кусках из total_cost — доля просмотренного при остановке
+    atomic_llong done_cost;
+    long long total_cost;
+    // Снимки не чаще раза в progress_ns; их вызывает задача, закончившая кусок (NULL — без снимков)
+    EngineProgress progress;
+    void* progress_arg;
+    long long progress_ns;
+    atomic_llong next_progress_ns;
+} Engine;
+
+// Состояние одного потока перебора; вершины — позиции в Engine::points
+typedef struct {
+    float best;         // квадрат нормы векторного произведения, корень берётся только у ответа
+    int i, j, k;        // -1 — треугольник не найден
+    TopK top;           // при top_k > 1
+    float* row_best;    // по tile_j элементов для обхода блоками
+    int* row_k;
+    float* norms;       // квадраты одного блока третьих вершин для top_k > 1
+    long long triples;  // троек, переданных ядру
+} Scan;
+
+// Копирует точки xyz[ids[0]], ..., xyz[ids[n-1]] (ids == NULL — первые n) и готовит оценки.
+// При top_k == 1 порогом сразу становится быстрый треугольник за O(n).
+int engine_init(Engine* engine, const float (*xyz)[3], const int* ids, int n, const EngineConfig* config);
+void engine_free(Engine* engine);
+
+int scan_init(Scan* scan, const Engine* engine);
+void scan_free(Scan* scan);
+
+// Перебор троек куска с обновлением результата потока
+void engine_scan_chunk(Engine* engine, const Chunk* chunk, Scan* scan);
+
+// Добавляет результат from к into: большая площадь, при равенстве — меньшие номера точек
+void scan_merge(Scan* into, const Scan* from);
+
+// Общий порог отсечения: поднимается, если value больше
+float engine_bound(Engine* engine);
+void engine_raise_bound(Engine* engine, float value);
+
+// Полный перебор: при threads > 1 куски раздаются threads задачам пула, иначе строки
+// перебираются в вызывающем потоке (со сроком, снимками или far_first — тоже кусками).
+// Результат записывается в out (после scan_init); после срока в нём лучшее из пройденного.
+int engine_run(Engine* engine, ThreadPool* pool, int threads, Scan* out);
+
+// Доля троек, пройденных последним engine_run: 1 — перебор полный
+double engine_coverage(Engine* engine);
@@ -0,0 +1,384 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "pool.h"
+#include "loader.h"
+
+// Генератор наборов точек в двоичном формате loader.h. Точки делятся на блоки по GEN_BLOCK,
+// у каждого блока свой поток псевдослучайных чисел, выведенный из seed и номера блока,
+// поэтому файл зависит только от seed и параметров, а не от числа потоков. Потоки пула
+// заполняют блоки и пишут их сразу на своё место в файле через pwrite.
+
+#define GEN_BLOCK 65536
+// Число уникальных точек по умолчанию для dup: одна на столько точек набора
+#define GEN_DUP_RATIO 1000
+
+typedef enum {
+    DIST_CUBE,      // равномерно в кубе [0, scale]^3
+    DIST_SPHERE,    // на сфере радиуса scale/2: все точки — вершины оболочки
+    DIST_GAUSS,     // нормальные облака вокруг случайных центров
+    DIST_COLLINEAR, // вдоль одного отрезка с небольшим шумом
+    DIST_DUP        // выборка с повторами из небольшого набора уникальных точек
+} Distribution;
+
+static const char* const dist_names[] = {"cube", "sphere", "gauss", "collinear", "dup"};
+
+typedef struct {
+    Distribution dist;
+    uint64_t seed;
+    long long count;
+    double scale;
+    int clusters;           // центров для gauss
+    double noise;           // доля scale: разброс облаков gauss и шум collinear
+    long long unique;       // уникальных точек для dup
+    double (*centers)[3];
+    double axis[3];         // направление отрезка collinear
+} GenParams;
+
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+static uint64_t splitmix64(uint64_t* state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Независимый поток для пары (seed, stream): состояние xoshiro256** заполняется через splitmix64
+static void rng_init(Rng* rng, uint64_t seed, uint64_t stream) {
+    uint64_t state = seed ^ splitmix64(&stream);
+    for (int w = 0; w < 4; ++w) {
+        rng->s[w] = splitmix64(&state);
+    }
+}
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t rng_next(Rng* rng) {
+    uint64_t* s = rng->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+// Равномерно в [0, 1)
+static inline double rng_uniform(Rng* rng) {
+    return (rng_next(rng) >> 11) * 0x1.0p-53;
+}
+
+// Стандартное нормальное (Бокс — Мюллер, второе значение не используется)
+static inline double rng_normal(Rng* rng) {
+    double u = 1.0 - rng_uniform(rng);
+    double v = rng_uniform(rng);
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+static void uniform_point(Rng* rng, double scale, float* out) {
+    for (int d = 0; d < 3; ++d) {
+        out[d] = (float)(rng_uniform(rng) * scale);
+    }
+}
+
+static void generate_point(const GenParams* params, Rng* rng, float* out) {
+    double half = params->scale / 2;
+    switch (params->dist) {
+    case DIST_CUBE:
+        uniform_point(rng, params->scale, out);
+        break;
+    case DIST_SPHERE: {
+        double v[3], len2;
+        do {
+            for (int d = 0; d < 3; ++d) v[d] = rng_normal(rng);
+            len2 = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+        } while (len2 < 1e-12);
+        double r = half / sqrt(len2);
+        for (int d = 0; d < 3; ++d) out[d] = (float)(half + v[d] * r);
+        break;
+    }
+    case DIST_GAUSS: {
+        const double* center = params->centers[rng_next(rng) % params->clusters];
+        for (int d = 0; d < 3; ++d) out[d] = (float)(center[d] + rng_normal(rng) * params->noise * params->scale);
+        break;
+    }
+    case DIST_COLLINEAR: {
+        double t = (rng_uniform(rng) - 0.5) * params->scale;
+        for (int d = 0; d < 3; ++d) {
+            out[d] = (float)(half + t * params->axis[d] + (rng_uniform(rng) - 0.5) * params->noise * params->scale);
+        }
+        break;
+    }
+    case DIST_DUP: {
+        // Уникальная точка u всегда строится из своего потока, так что таблица не нужна
+        Rng unique;
+        rng_init(&unique, params->seed, UINT64_MAX - rng_next(rng) % params->unique);
+        uniform_point(&unique, params->scale, out);
+        break;
+    }
+    }
+}
+
+typedef struct {
+    const GenParams* params;
+    int fd;
+    long long blocks;
+    atomic_llong next_block;
+    atomic_int failed;
+} GenJob;
+
+static void GenWorker(void* arg) {
+    GenJob* job = (GenJob*) arg;
+    const GenParams* params = job->params;
+    float (*buf)[3] = malloc(GEN_BLOCK * sizeof(*buf));
+    if (buf == NULL) {
+        atomic_store(&job->failed, ENOMEM);
+        return;
+    }
+    long long b;
+    while ((b = atomic_fetch_add(&job->next_block, 1)) < job->blocks && atomic_load(&job->failed) == 0) {
+        long long first = b * GEN_BLOCK;
+        long long count = params->count - first < GEN_BLOCK ? params->count - first : GEN_BLOCK;
+        Rng rng;
+        rng_init(&rng, params->seed, (uint64_t)b);
+        for (long long p = 0; p < count; ++p) {
+            generate_point(params, &rng, buf[p]);
+        }
+        const char* data = (const char*)buf;
+        size_t left = count * sizeof(*buf);
+        off_t offset = sizeof(PointsHeader) + first * (off_t)sizeof(*buf);
+        while (left > 0) {
+            ssize_t written = pwrite(job->fd, data, left, offset);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) {
+                atomic_store(&job->failed, written < 0 ? errno : EIO);
+                break;
+            }
+            data += written;
+            left -= written;
+            offset += written;
+        }
+    }
+    free(buf);
+}
+
+static void usage(const char* prog) {
+    printf("Usage: %s [--dist cube|sphere|gauss|collinear|dup] [--seed n] [--threads n] [--scale s] "
+           "[--clusters n] [--noise f] [--unique n] [--pin none|compact|scatter] <num_points> <file>\n", prog);
+}
+
+int main(int argc, char* argv[]) {
+    GenParams params = {0};
+    params.dist = DIST_CUBE;
+    params.seed = 1;
+    params.scale = 100.0;
+    params.clusters = 8;
+    params.noise = -1.0;
+    params.unique = 0;
+    int threads = pool_cpu_count();
+    int pin = PIN_COMPACT;
+    static const struct option long_options[] = {
+        {"dist", required_argument, NULL, 'd'},
+        {"seed", required_argument, NULL, 's'},
+        {"threads", required_argument, NULL, 't'},
+        {"scale", required_argument, NULL, 'S'},
+        {"clusters", required_argument, NULL, 'c'},
+        {"noise", required_argument, NULL, 'e'},
+        {"unique", required_argument, NULL, 'u'},
+        {"pin", required_argument, NULL, 'P'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    char* endptr;
+    while ((opt = getopt_long(argc, argv, "d:s:t:S:c:e:u:P:", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 'd': {
+            int found = -1;
+            for (int d = 0; d < (int)(sizeof(dist_names) / sizeof(dist_names[0])); ++d) {
+                if (strcmp(optarg, dist_names[d]) == 0) {
+                    found = d;
+                }
+            }
+            if (found < 0) {
+                printf("Unknown distribution: %s\n", optarg);
+                return 1;
+            }
+            params.dist = (Distribution)found;
+            break;
+        }
+        case 's':
+            params.seed = strtoull(optarg, &endptr, 10);
+            if (*endptr != '\0' || optarg[0] == '-') {
+                printf("Seed must be a non-negative integer\n");
+                return 1;
+            }
+            break;
+        case 't':
+            threads = (int)strtol(optarg, &endptr, 10);
+            if (*endptr != '\0' || threads < 1) {
+                printf("Number of threads must be a positive integer\n");
+                return 1;
+            }
+            break;
+        case 'S':
+            params.scale = strtod(optarg, &endptr);
+            if (*endptr != '\0' || !(params.scale > 0.0)) {
+                printf("Scale must be positive\n");
+                return 1;
+            }
+            break;
+        case 'c':
+            params.clusters = (int)strtol(optarg, &endptr, 10);
+            if (*endptr != '\0' || params.clusters < 1 || params.clusters > 1000000) {
+                printf("Number of clusters must be between 1 and 1000000\n");
+                return 1;
+            }
+            break;
+        case 'e':
+            params.noise = strtod(optarg, &endptr);
+            if (*endptr != '\0' || !(params.noise >= 0.0)) {
+                printf("Noise must be non-negative\n");
+                return 1;
+            }
+            break;
+        case 'u':
+            params.unique = strtoll(optarg, &endptr, 10);
+            if (*endptr != '\0' || params.unique < 1) {
+                printf("Number of unique points must be positive\n");
+                return 1;
+            }
+            break;
+        case 'P':
+            pin = pool_parse_pin(optarg);
+            if (pin < 0) {
+                printf("Unknown pinning policy: %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (argc - optind != 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    params.count = strtoll(argv[optind], &endptr, 10);
+    if (*endptr != '\0' || params.count < 1) {
+        printf("Number of points must be a positive integer\n");
+        return 1;
+    }
+    const char* path = argv[optind + 1];
+
+    // Шум по умолчанию: облака gauss по 5% размера, отклонение collinear от прямой 0.1%
+    if (params.noise < 0.0) {
+        params.noise = params.dist == DIST_GAUSS ? 0.05 : 0.001;
+    }
+    if (params.unique == 0) {
+        params.unique = params.count / GEN_DUP_RATIO > 0 ? params.count / GEN_DUP_RATIO : 1;
+    }
+    // Центры облаков и направление отрезка берутся из отдельного потока того же seed
+    Rng setup;
+    rng_init(&setup, params.seed, UINT64_MAX / 2);
+    params.centers = malloc(params.clusters * sizeof(*params.centers));
+    for (int c = 0; c < params.clusters; ++c) {
+        for (int d = 0; d < 3; ++d) {
+            params.centers[c][d] = (0.1 + 0.8 * rng_uniform(&setup)) * params.scale;
+        }
+    }
+    double len2;
+    do {
+        len2 = 0.0;
+        for (int d = 0; d < 3; ++d) {
+            params.axis[d] = rng_normal(&setup);
+            len2 += params.axis[d] * params.axis[d];
+        }
+    } while (len2 < 1e-12);
+    for (int d = 0; d < 3; ++d) {
+        params.axis[d] /= sqrt(len2);
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf("Failed to create %s\n", path);
+        return 1;
+    }
+    PointsHeader header = {0};
+    memcpy(header.magic, POINTS_MAGIC, sizeof(header.magic));
+    header.version = POINTS_VERSION;
+    header.dim = 3;
+    header.scalar_size = sizeof(float);
+    header.count = params.count;
+    off_t size = sizeof(header) + params.count * (off_t)(3 * sizeof(float));
+    // Место выделяется заранее, чтобы блоки не растягивали файл по очереди
+    int status = posix_fallocate(fd, 0, size);
+    if (status == EINVAL || status == EOPNOTSUPP) {
+        status = ftruncate(fd, size) == 0 ? 0 : errno;
+    }
+    if (status != 0 || pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+        printf("Failed to write %s: %s\n", path, strerror(status ? status : errno));
+        close(fd);
+        return 1;
+    }
+
+    GenJob job;
+    job.params = &params;
+    job.fd = fd;
+    job.blocks = (params.count + GEN_BLOCK - 1) / GEN_BLOCK;
+    atomic_init(&job.next_block, 0);
+    atomic_init(&job.failed, 0);
+    if (threads > job.blocks) {
+        threads = (int)job.blocks;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (threads > 1) {
+        ThreadPool* pool = pool_create(threads, threads, pin);
+        if (pool == NULL) {
+            printf("Failed to create threads\n");
+            return 1;
+        }
+        TaskGroup group = {0};
+        for (int t = 0; t < threads; ++t) {
+            pool_submit(pool, &group, GenWorker, &job);
+        }
+        pool_wait(pool, &group);
+        pool_destroy(pool);
+    } else {
+        GenWorker(&job);
+    }
+    int failed = atomic_load(&job.failed);
+    if (close(fd) != 0 && failed == 0) {
+        failed = errno;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free(params.centers);
+    if (failed != 0) {
+        printf("Failed to write %s: %s\n", path, strerror(failed));
+        return 1;
+    }
+    long long time_ms = (end.tv_sec - start.tv_sec) * 1000LL + (end.tv_nsec - start.tv_nsec) / 1000000LL;
+    printf("Generated %lld points (%s, seed %llu) in %lld ms with %d threads\n", params.count,
+           dist_names[params.dist], (unsigned long long)params.seed, time_ms, threads);
+    return 0;
+}
@@ -1,5 +1,6 @@
 #!/usr/bin/env python3
 import random
+import struct
 import sys
 
 def generate_coordinates(num_points, min_val=0, max_val=100):
@@ -24,9 +25,16 @@ def write_to_file(coordinates, filename="coordinates_data.c"):
         f.write('};\n\n')
         f.write(f'int num_points = {num_points};\n')
 
+def write_binary(coordinates, filename):
+    """Записывает координаты в двоичном формате для ключа --input (см. loader.h)."""
+    with open(filename, 'wb') as f:
+        f.write(struct.pack('=8sIIIIQ', b'MAXTRI3D', 1, 3, 4, 0, len(coordinates)))
+        for coord in coordinates:
+            f.write(struct.pack('=3f', *coord))
+
 def main():
-    if len(sys.argv) != 2:
-        print("Использование: python generate_coords.py <num_points>")
+    if len(sys.argv) not in (2, 3):
+        print("Использование: python generate_coords.py <num_points> [points.bin]")
         sys.exit(1)
 
     try:
@@ -38,6 +46,10 @@ def main():
         sys.exit(1)
 
     coordinates = generate_coordinates(num_points)
+    if len(sys.argv) == 3:
+        write_binary(coordinates, sys.argv[2])
+        print(f"Координаты записаны в {sys.argv[2]}")
+        return
     write_to_file(coordinates)
     print(f"Координаты записаны в coordinates_data.c")
 
@@ -0,0 +1,425 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "hull.h"
+
+// Quickhull в 3D. Грани хранятся треугольниками с соседями через рёбра,
+// у каждой грани свой список точек, лежащих над ней.
+
+typedef struct {
+    int v[3];       // вершины (локальные номера), обход против часовой стрелки снаружи
+    int nb[3];      // соседняя грань через ребро v[e] -> v[e + 1]
+    double n[3], d; // плоскость n·x = d, нормаль единичная и смотрит наружу
+    int* out;       // точки над гранью
+    int out_count, out_cap;
+    int visible;
+    int alive;
+} Face;
+
+typedef struct {
+    double (*p)[3];
+    Face* faces;
+    int face_count, face_cap;
+    double eps;
+} Hull;
+
+typedef struct {
+    int a, b, face;
+} HorizonEdge;
+
+typedef struct {
+    int face, start, step;
+} VisitFrame;
+
+static double face_dist(const Face* f, const double* p) {
+    return f->n[0] * p[0] + f->n[1] * p[1] + f->n[2] * p[2] - f->d;
+}
+
+// Номер новой грани; -1 — не хватило памяти
+static int face_add(Hull* h, int a, int b, int c) {
+    if (h->face_count == h->face_cap) {
+        int cap = h->face_cap ? h->face_cap * 2 : 64;
+        Face* grown = realloc(h->faces, cap * sizeof(Face));
+        if (grown == NULL) {
+            return -1;
+        }
+        h->faces = grown;
+        h->face_cap = cap;
+    }
+    Face* f = &h->faces[h->face_count];
+    memset(f, 0, sizeof(Face));
+    f->v[0] = a;
+    f->v[1] = b;
+    f->v[2] = c;
+    f->alive = 1;
+    const double* pa = h->p[a];
+    const double* pb = h->p[b];
+    const double* pc = h->p[c];
+    double ux = pb[0] - pa[0], uy = pb[1] - pa[1], uz = pb[2] - pa[2];
+    double wx = pc[0] - pa[0], wy = pc[1] - pa[1], wz = pc[2] - pa[2];
+    double nx = uy * wz - uz * wy;
+    double ny = uz * wx - ux * wz;
+    double nz = ux * wy - uy * wx;
+    double len = sqrt(nx * nx + ny * ny + nz * nz);
+    if (len > 0.0) {
+        f->n[0] = nx / len;
+        f->n[1] = ny / len;
+        f->n[2] = nz / len;
+        f->d = f->n[0] * pa[0] + f->n[1] * pa[1] + f->n[2] * pa[2];
+    }
+    return h->face_count++;
+}
+
+// 0 — не хватило памяти
+static int face_push(Face* f, int point) {
+    if (f->out_count == f->out_cap) {
+        int cap = f->out_cap ? f->out_cap * 2 : 16;
+        int* grown = realloc(f->out, cap * sizeof(int));
+        if (grown == NULL) {
+            return 0;
+        }
+        f->out = grown;
+        f->out_cap = cap;
+    }
+    f->out[f->out_count++] = point;
+    return 1;
+}
+
+static int edge_index(const Face* f, int a, int b) {
+    for (int e = 0; e < 3; ++e) {
+        if (f->v[e] == a && f->v[(e + 1) % 3] == b) {
+            return e;
+        }
+    }
+    return -1;
+}
+
+static int cmp_int(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+static int copy_all(const int* idx, int n, int* out) {
+    memcpy(out, idx, n * sizeof(int));
+    qsort(out, n, sizeof(int), cmp_int);
+    return n;
+}
+
+static double dist2(const double* a, const double* b) {
+    double dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// Квадрат расстояния от точки p до прямой ab
+static double line_dist2(const double* a, const double* b, const double* p) {
+    double ux = b[0] - a[0], uy = b[1] - a[1], uz = b[2] - a[2];
+    double wx = p[0] - a[0], wy = p[1] - a[1], wz = p[2] - a[2];
+    double cx = uy * wz - uz * wy;
+    double cy = uz * wx - ux * wz;
+    double cz = ux * wy - uy * wx;
+    double len2 = ux * ux + uy * uy + uz * uz;
+    return len2 > 0.0 ? (cx * cx + cy * cy + cz * cz) / len2 : 0.0;
+}
+
+// Начальный тетраэдр: 0 — вырожденный набор или не хватило памяти
+static int build_simplex(Hull* h, int n, int s[4]) {
+    int ext[6] = {0, 0, 0, 0, 0, 0};
+    for (int t = 1; t < n; ++t) {
+        for (int c = 0; c < 3; ++c) {
+            if (h->p[t][c] < h->p[ext[2 * c]][c]) ext[2 * c] = t;
+            if (h->p[t][c] > h->p[ext[2 * c + 1]][c]) ext[2 * c + 1] = t;
+        }
+    }
+    double best = -1.0;
+    for (int a = 0; a < 6; ++a) {
+        for (int b = a + 1; b < 6; ++b) {
+            double d = dist2(h->p[ext[a]], h->p[ext[b]]);
+            if (d > best) {
+                best = d;
+                s[0] = ext[a];
+                s[1] = ext[b];
+            }
+        }
+    }
+    if (sqrt(best) <= h->eps) return 0;
+
+    best = -1.0;
+    for (int t = 0; t < n; ++t) {
+        double d = line_dist2(h->p[s[0]], h->p[s[1]], h->p[t]);
+        if (d > best) {
+            best = d;
+            s[2] = t;
+        }
+    }
+    if (sqrt(best) <= h->eps) return 0;
+
+    if (face_add(h, s[0], s[1], s[2]) < 0) return 0;
+    best = -1.0;
+    for (int t = 0; t < n; ++t) {
+        double d = fabs(face_dist(&h->faces[0], h->p[t]));
+        if (d > best) {
+            best = d;
+            s[3] = t;
+        }
+    }
+    if (best <= h->eps) return 0;
+
+    // Четвёртая вершина должна оказаться под первой гранью
+    if (face_dist(&h->faces[0], h->p[s[3]]) > 0) {
+        int tmp = s[1];
+        s[1] = s[2];
+        s[2] = tmp;
+    }
+    h->face_count = 0;
+    if (face_add(h, s[0], s[1], s[2]) < 0 || face_add(h, s[1], s[0], s[3]) < 0
+        || face_add(h, s[2], s[1], s[3]) < 0 || face_add(h, s[0], s[2], s[3]) < 0) {
+        return 0;
+    }
+    for (int f = 0; f < 4; ++f) {
+        for (int e = 0; e < 3; ++e) {
+            Face* face = &h->faces[f];
+            for (int g = 0; g < 4; ++g) {
+                if (g != f && edge_index(&h->faces[g], face->v[(e + 1) % 3], face->v[e]) >= 0) {
+                    face->nb[e] = g;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+// Добавляет точку p, видимую с грани start. 0 — горизонт получился некорректным или не хватило памяти.
+static int add_point(Hull* h, int start, int p, VisitFrame** stack, int* stack_cap,
+                     HorizonEdge** horizon, int* horizon_cap, int** visible, int* visible_cap) {
+    int stack_size = 0, horizon_size = 0, visible_size = 0;
+
+    // Обход видимых граней в глубину: горизонт собирается по порядку
+    h->faces[start].visible = 1;
+    (*visible)[visible_size++] = start;
+    (*stack)[stack_size++] = (VisitFrame){start, 0, 0};
+    while (stack_size > 0) {
+        VisitFrame* top = &(*stack)[stack_size - 1];
+        if (top->step == 3) {
+            --stack_size;
+            continue;
+        }
+        int f = top->face;
+        int e = (top->start + top->step++) % 3;
+        int g = h->faces[f].nb[e];
+        if (h->faces[g].visible) {
+            continue;
+        }
+        if (face_dist(&h->faces[g], h->p[p]) > h->eps) {
+            h->faces[g].visible = 1;
+            if (visible_size == *visible_cap) {
+                int* grown = realloc(*visible, *visible_cap * 2 * sizeof(int));
+                if (grown == NULL) return 0;
+                *visible = grown;
+                *visible_cap *= 2;
+            }
+            (*visible)[visible_size++] = g;
+            if (stack_size == *stack_cap) {
+                VisitFrame* grown = realloc(*stack, *stack_cap * 2 * sizeof(VisitFrame));
+                if (grown == NULL) return 0;
+                *stack = grown;
+                *stack_cap *= 2;
+            }
+            int back = edge_index(&h->faces[g], h->faces[f].v[(e + 1) % 3], h->faces[f].v[e]);
+            (*stack)[stack_size++] = (VisitFrame){g, back + 1, 0};
+        } else {
+            if (horizon_size == *horizon_cap) {
+                HorizonEdge* grown = realloc(*horizon, *horizon_cap * 2 * sizeof(HorizonEdge));
+                if (grown == NULL) return 0;
+                *horizon = grown;
+                *horizon_cap *= 2;
+            }
+            (*horizon)[horizon_size++] = (HorizonEdge){h->faces[f].v[e], h->faces[f].v[(e + 1) % 3], g};
+        }
+    }
+
+    for (int t = 0; t < horizon_size; ++t) {
+        if ((*horizon)[t].b != (*horizon)[(t + 1) % horizon_size].a) {
+            return 0;
+        }
+    }
+
+    // Конус новых граней из p на рёбра горизонта
+    int first = h->face_count;
+    for (int t = 0; t < horizon_size; ++t) {
+        HorizonEdge he = (*horizon)[t];
+        int nf = face_add(h, he.a, he.b, p);
+        if (nf < 0) return 0;
+        Face* face = &h->faces[nf];
+        face->nb[0] = he.face;
+        face->nb[1] = first + (t + 1) % horizon_size;
+        face->nb[2] = first + (t + horizon_size - 1) % horizon_size;
+        Face* outer = &h->faces[he.face];
+        outer->nb[edge_index(outer, he.b, he.a)] = nf;
+    }
+
+    // Точки видимых граней переходят к новым граням или оказываются внутри
+    for (int t = 0; t < visible_size; ++t) {
+        Face* old = &h->faces[(*visible)[t]];
+        for (int q = 0; q < old->out_count; ++q) {
+            int point = old->out[q];
+            if (point == p) continue;
+            for (int nf = first; nf < h->face_count; ++nf) {
+                if (face_dist(&h->faces[nf], h->p[point]) > h->eps) {
+                    if (!face_push(&h->faces[nf], point)) return 0;
+                    break;
+                }
+            }
+        }
+        free(old->out);
+        old->out = NULL;
+        old->out_count = old->out_cap = 0;
+        old->alive = 0;
+    }
+    return 1;
+}
+
+int hull_vertices(const float (*xyz)[3], const int* idx, int n, int* out) {
+    if (n < 4) {
+        return copy_all(idx, n, out);
+    }
+
+    Hull h = {0};
+    h.p = malloc(n * sizeof(*h.p));
+    if (h.p == NULL) {
+        return copy_all(idx, n, out);
+    }
+    double scale = 0.0;
+    for (int t = 0; t < n; ++t) {
+        for (int c = 0; c < 3; ++c) {
+            h.p[t][c] = xyz[idx[t]][c];
+            if (fabs(h.p[t][c]) > scale) scale = fabs(h.p[t][c]);
+        }
+    }
+    h.eps = 1e-10 * (scale > 1.0 ? scale : 1.0);
+
+    int s[4] = {0, 0, 0, 0};
+    int ok = build_simplex(&h, n, s);
+    if (ok) {
+        for (int t = 0; t < n; ++t) {
+            if (t == s[0] || t == s[1] || t == s[2] || t == s[3]) continue;
+            for (int f = 0; ok && f < 4; ++f) {
+                if (face_dist(&h.faces[f], h.p[t]) > h.eps) {
+                    ok = face_push(&h.faces[f], t);
+                    break;
+                }
+            }
+        }
+
+        int stack_cap = 64, horizon_cap = 64, visible_cap = 64;
+        VisitFrame* stack = malloc(stack_cap * sizeof(VisitFrame));
+        HorizonEdge* horizon = malloc(horizon_cap * sizeof(HorizonEdge));
+        int* visible = malloc(visible_cap * sizeof(int));
+        ok = ok && stack != NULL && horizon != NULL && visible != NULL;
+        for (int f = 0; ok && f < h.face_count; ++f) {
+            Face* face = &h.faces[f];
+            if (!face->alive || face->out_count == 0) continue;
+            int far = face->out[0];
+            double far_dist = face_dist(face, h.p[far]);
+            for (int q = 1; q < face->out_count; ++q) {
+                double d = face_dist(face, h.p[face->out[q]]);
+                if (d > far_dist) {
+                    far_dist = d;
+                    far = face->out[q];
+                }
+            }
+            ok = add_point(&h, f, far, &stack, &stack_cap, &horizon, &horizon_cap, &visible, &visible_cap);
+        }
+        free(stack);
+        free(horizon);
+        free(visible);
+    }
+
+    int count;
+    char* used = ok ? calloc(n, 1) : NULL;
+    if (used != NULL) {
+        for (int f = 0; f < h.face_count; ++f) {
+            if (!h.faces[f].alive) continue;
+            for (int e = 0; e < 3; ++e) {
+                used[h.faces[f].v[e]] = 1;
+            }
+        }
+        count = 0;
+        for (int t = 0; t < n; ++t) {
+            if (used[t]) out[count++] = idx[t];
+        }
+        qsort(out, count, sizeof(int), cmp_int);
+        free(used);
+    } else {
+        // Плоский набор, сбой точности или нехватка памяти: фильтровать нечего, оставляем все точки
+        count = copy_all(idx, n, out);
+    }
+
+    for (int f = 0; f < h.face_count; ++f) {
+        free(h.faces[f].out);
+    }
+    free(h.faces);
+    free(h.p);
+    return count;
+}
+
+typedef struct {
+    const float (*xyz)[3];
+    int* idx;
+    int n;
+    int* out;
+    int count;
+} HullArgs;
+
+static void HullPart(void* arg) {
+    HullArgs* args = (HullArgs*) arg;
+    args->count = hull_vertices(args->xyz, args->idx, args->n, args->out);
+}
+
+int hull_vertices_parallel(const float (*xyz)[3], int n, ThreadPool* pool, int* out) {
+    int* idx = malloc(n * sizeof(int));
+    if (idx == NULL) {
+        for (int t = 0; t < n; ++t) {
+            out[t] = t;
+        }
+        return n;
+    }
+    for (int t = 0; t < n; ++t) {
+        idx[t] = t;
+    }
+    int threads = pool ? pool_workers(pool) : 1;
+    if (threads > n / 1024) {
+        threads = n / 1024;
+    }
+    // Оболочки частей: вершина общей оболочки всегда вершина оболочки своей части
+    int* part = threads > 1 ? malloc(n * sizeof(int)) : NULL;
+    HullArgs* args = threads > 1 ? malloc(threads * sizeof(HullArgs)) : NULL;
+    if (part == NULL || args == NULL) {
+        int count = hull_vertices(xyz, idx, n, out);
+        free(args);
+        free(part);
+        free(idx);
+        return count;
+    }
+    TaskGroup group = {0};
+    for (int t = 0; t < threads; ++t) {
+        int from = (int)((long long)n * t / threads);
+        int to = (int)((long long)n * (t + 1) / threads);
+        args[t].xyz = xyz;
+        args[t].idx = idx + from;
+        args[t].n = to - from;
+        args[t].out = part + from;
+        pool_submit(pool, &group, HullPart, &args[t]);
+    }
+    pool_wait(pool, &group);
+    int merged = 0;
+    for (int t = 0; t < threads; ++t) {
+        memmove(idx + merged, args[t].out, args[t].count * sizeof(int));
+        merged += args[t].count;
+    }
+    int count = hull_vertices(xyz, idx, merged, out);
+
+    free(args);
+    free(part);
+    free(idx);
+    return count;
+}
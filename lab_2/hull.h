@@ -0,0 +1,13 @@
+#pragma once
+
+#include "pool.h"
+
+// Вершины выпуклой оболочки точек xyz[idx[0]], ..., xyz[idx[n-1]].
+// В out (не меньше n элементов) записываются исходные индексы вершин по возрастанию,
+// возвращается их количество. Если все точки лежат в одной плоскости, оболочка
+// не строится и в out копируются все индексы.
+int hull_vertices(const float (*xyz)[3], const int* idx, int n, int* out);
+
+// То же для первых n точек массива: точки делятся на части по числу потоков пула, оболочки частей
+// строятся параллельно, затем строится оболочка объединения их вершин. pool == NULL — в одном потоке.
+int hull_vertices_parallel(const float (*xyz)[3], int n, ThreadPool* pool, int* out);
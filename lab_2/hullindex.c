@@ -0,0 +1,301 @@
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "hullindex.h"
+#include "hull.h"
+
+// Узлов одного уровня на задачу пула: оболочки листьев по 1024 точки строятся за десятки микросекунд
+#define HULL_INDEX_NODES_PER_TASK 16
+
+static uint64_t points_fingerprint(const float (*xyz)[3], int n) {
+    const unsigned char* bytes = (const unsigned char*)xyz;
+    size_t size = (size_t)n * 3 * sizeof(float);
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t b = 0; b < size; ++b) {
+        hash = (hash ^ bytes[b]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Листьев, округлённое вверх до степени двойки: тогда у узла v дети 2v и 2v + 1
+static int leaves_for(int n, int leaf) {
+    int blocks = (n + leaf - 1) / leaf;
+    int leaves = 1;
+    while (leaves < blocks) {
+        leaves *= 2;
+    }
+    return leaves;
+}
+
+typedef struct {
+    const float (*xyz)[3];
+    int n;
+    int leaves;
+    int** ids;          // номера вершин оболочки узла; NULL — узел пуст
+    int* counts;
+    int v_begin, v_end; // узлы задачи
+    int failed;
+} BuildTask;
+
+// Оболочка листа строится по его точкам, оболочка внутреннего узла — по вершинам оболочек детей
+static void BuildNodes(void* arg) {
+    BuildTask* task = (BuildTask*) arg;
+    for (int v = task->v_begin; v < task->v_end && !task->failed; ++v) {
+        int total;
+        int* idx;
+        if (v >= task->leaves) {
+            int begin = (v - task->leaves) * HULL_INDEX_LEAF;
+            int end = begin + HULL_INDEX_LEAF < task->n ? begin + HULL_INDEX_LEAF : task->n;
+            total = end > begin ? end - begin : 0;
+            idx = malloc((total > 0 ? total : 1) * sizeof(int));
+            for (int t = 0; idx != NULL && t < total; ++t) {
+                idx[t] = begin + t;
+            }
+        } else {
+            int left = 2 * v, right = 2 * v + 1;
+            total = task->counts[left] + task->counts[right];
+            idx = malloc((total > 0 ? total : 1) * sizeof(int));
+            if (idx != NULL) {
+                memcpy(idx, task->ids[left], task->counts[left] * sizeof(int));
+                memcpy(idx + task->counts[left], task->ids[right], task->counts[right] * sizeof(int));
+            }
+        }
+        int* out = malloc((total > 0 ? total : 1) * sizeof(int));
+        if (idx == NULL || out == NULL) {
+            free(idx);
+            free(out);
+            task->failed = 1;
+            return;
+        }
+        task->counts[v] = hull_vertices(task->xyz, idx, total, out);
+        free(idx);
+        task->ids[v] = out;
+    }
+}
+
+const char* hull_index_build(const float (*xyz)[3], int n, ThreadPool* pool, const char* path, long long* ids_total) {
+    int leaves = leaves_for(n, HULL_INDEX_LEAF);
+    int nodes = 2 * leaves;
+    int** ids = calloc(nodes, sizeof(int*));
+    int* counts = calloc(nodes, sizeof(int));
+    BuildTask* tasks = malloc((leaves / HULL_INDEX_NODES_PER_TASK + 1) * sizeof(BuildTask));
+    const char* error = NULL;
+    if (ids == NULL || counts == NULL || tasks == NULL) {
+        error = "out of memory";
+        goto done;
+    }
+
+    // Уровни снизу вверх: узлы уровня [level, 2·level) независимы друг от друга
+    for (int level = leaves; level >= 1 && error == NULL; level /= 2) {
+        TaskGroup group = {0};
+        int task_count = 0;
+        for (int v = level; v < 2 * level; v += HULL_INDEX_NODES_PER_TASK) {
+            BuildTask* task = &tasks[task_count++];
+            task->xyz = xyz;
+            task->n = n;
+            task->leaves = leaves;
+            task->ids = ids;
+            task->counts = counts;
+            task->v_begin = v;
+            task->v_end = v + HULL_INDEX_NODES_PER_TASK < 2 * level ? v + HULL_INDEX_NODES_PER_TASK : 2 * level;
+            task->failed = 0;
+            if (pool != NULL) {
+                pool_submit(pool, &group, BuildNodes, task);
+            } else {
+                BuildNodes(task);
+            }
+        }
+        if (pool != NULL) {
+            pool_wait(pool, &group);
+        }
+        for (int t = 0; t < task_count; ++t) {
+            if (tasks[t].failed) {
+                error = "out of memory";
+            }
+        }
+    }
+    if (error != NULL) {
+        goto done;
+    }
+
+    HullIndexHeader header = {0};
+    memcpy(header.magic, HULL_INDEX_MAGIC, sizeof(header.magic));
+    header.version = HULL_INDEX_VERSION;
+    header.leaf = HULL_INDEX_LEAF;
+    header.count = n;
+    header.fingerprint = points_fingerprint(xyz, n);
+    header.nodes = nodes;
+    HullIndexNode* table = calloc(nodes, sizeof(HullIndexNode));
+    if (table == NULL) {
+        error = "out of memory";
+        goto done;
+    }
+    for (int v = 0; v < nodes; ++v) {
+        table[v].offset = header.ids;
+        table[v].count = counts[v];
+        header.ids += counts[v];
+    }
+    *ids_total = (long long)header.ids;
+
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) {
+        free(table);
+        error = "failed to create file";
+        goto done;
+    }
+    // Номера неотрицательны и помещаются в int, поэтому записываются как uint32 без преобразования
+    int ok = fwrite(&header, sizeof(header), 1, f) == 1
+          && fwrite(table, sizeof(HullIndexNode), nodes, f) == (size_t)nodes;
+    for (int v = 0; ok && v < nodes; ++v) {
+        ok = fwrite(ids[v], sizeof(uint32_t), counts[v], f) == (size_t)counts[v];
+    }
+    if (fclose(f) != 0) {
+        ok = 0;
+    }
+    free(table);
+    if (!ok) {
+        error = "failed to write file";
+    }
+
+done:
+    for (int v = 0; ids != NULL && v < nodes; ++v) {
+        free(ids[v]);
+    }
+    free(ids);
+    free(counts);
+    free(tasks);
+    return error;
+}
+
+const char* hull_index_open(HullIndex* index, const char* path, const float (*xyz)[3], int n) {
+    memset(index, 0, sizeof(HullIndex));
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return "failed to open file";
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return "failed to stat file";
+    }
+    size_t size = st.st_size;
+    if (size < sizeof(HullIndexHeader)) {
+        close(fd);
+        return "not a hull index";
+    }
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return "failed to map file";
+    }
+
+    const HullIndexHeader* header = map;
+    const char* error = NULL;
+    if (memcmp(header->magic, HULL_INDEX_MAGIC, sizeof(header->magic)) != 0) {
+        error = "not a hull index";
+    } else if (header->version != HULL_INDEX_VERSION) {
+        error = "unsupported index format version";
+    } else if (header->leaf != HULL_INDEX_LEAF || header->nodes != 2ULL * leaves_for(n, HULL_INDEX_LEAF)
+               || (size - sizeof(HullIndexHeader)) / sizeof(HullIndexNode) < header->nodes
+               || (size - sizeof(HullIndexHeader) - header->nodes * sizeof(HullIndexNode)) / sizeof(uint32_t) < header->ids) {
+        error = header->count != (uint64_t)n ? "index was built for another point set" : "index file is damaged";
+    } else if (header->count != (uint64_t)n || header->fingerprint != points_fingerprint(xyz, n)) {
+        error = "index was built for another point set";
+    }
+    if (error != NULL) {
+        munmap(map, size);
+        return error;
+    }
+    index->map = map;
+    index->map_size = size;
+    index->header = header;
+    index->nodes = (const HullIndexNode*)(header + 1);
+    index->ids = (const uint32_t*)(index->nodes + header->nodes);
+    index->n = n;
+    index->leaf = HULL_INDEX_LEAF;
+    index->leaves = (int)(header->nodes / 2);
+    for (uint64_t v = 0; v < header->nodes; ++v) {
+        if (index->nodes[v].offset + index->nodes[v].count > header->ids) {
+            hull_index_close(index);
+            return "index file is damaged";
+        }
+    }
+    return NULL;
+}
+
+void hull_index_close(HullIndex* index) {
+    if (index->map != NULL) {
+        munmap(index->map, index->map_size);
+    }
+    memset(index, 0, sizeof(HullIndex));
+}
+
+static int push_node(const HullIndex* index, int v, int* out, int count) {
+    const HullIndexNode* node = &index->nodes[v];
+    const uint32_t* ids = index->ids + node->offset;
+    for (uint32_t t = 0; t < node->count; ++t) {
+        out[count++] = (int)ids[t];
+    }
+    return count;
+}
+
+int hull_index_find(const HullIndex* index, const float (*xyz)[3], int l, int r, const maxtri_opts* opts,
+                    maxtri_result* out) {
+    memset(out, 0, sizeof(maxtri_result));
+    out->best.i = out->best.j = out->best.k = -1;
+    // Остальные лучшие треугольники не обязаны лежать на оболочке, поэтому top_k > 1 не поддерживается
+    if (l < 0 || r > index->n || r - l < 3 || opts->backend == MAXTRI_HULL || opts->top_k > 1) {
+        return MAXTRI_EINVAL;
+    }
+    // Кандидатов не больше r - l: узлы и края покрывают [l, r) без пересечений
+    int* idx = malloc((r - l) * sizeof(int));
+    int* hull = malloc((r - l) * sizeof(int));
+    float (*points)[3] = malloc((size_t)(r - l) * sizeof(*points));
+    if (idx == NULL || hull == NULL || points == NULL) {
+        free(idx);
+        free(hull);
+        free(points);
+        return MAXTRI_ENOMEM;
+    }
+
+    // Неполные листья по краям берутся точками, целые листья [a, b) — узлами дерева
+    int leaf = index->leaf;
+    int a = (l + leaf - 1) / leaf;
+    int b = r / leaf;
+    int count = 0;
+    if (a >= b) {
+        for (int p = l; p < r; ++p) idx[count++] = p;
+    } else {
+        for (int p = l; p < a * leaf; ++p) idx[count++] = p;
+        for (int p = b * leaf; p < r; ++p) idx[count++] = p;
+        for (int lo = a + index->leaves, hi = b + index->leaves; lo < hi; lo /= 2, hi /= 2) {
+            if (lo & 1) count = push_node(index, lo++, idx, count);
+            if (hi & 1) count = push_node(index, --hi, idx, count);
+        }
+    }
+    // Собранное обычно намного меньше диапазона, и его оболочка строится за доли миллисекунды
+    int m = hull_vertices(xyz, idx, count, hull);
+    for (int t = 0; t < m; ++t) {
+        memcpy(points[t], xyz[hull[t]], sizeof(points[t]));
+    }
+    int status = maxtri_find(&points[0][0], m, opts, out);
+    if (status == MAXTRI_OK) {
+        if (out->best.i >= 0) {
+            out->best.i = hull[out->best.i];
+            out->best.j = hull[out->best.j];
+            out->best.k = hull[out->best.k];
+        }
+        out->hull_count = m;
+        out->candidates = m;
+    }
+    free(idx);
+    free(hull);
+    free(points);
+    return status;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "maxtri.h"
+
+// Индекс оболочек для запросов по диапазонам точек [l, r). Точки делятся на листья
+// по HULL_INDEX_LEAF подряд, над листьями — дерево отрезков: в каждом узле хранятся номера
+// вершин выпуклой оболочки его точек. Вершины оболочки объединения — среди вершин оболочек частей,
+// поэтому запрос собирает O(log n) узлов целиком вошедших листьев и точки двух неполных листьев
+// по краям, а перебор идёт только по вершинам оболочки собранного.
+#define HULL_INDEX_LEAF 1024
+
+#define HULL_INDEX_MAGIC "MAXTRIIX"
+#define HULL_INDEX_VERSION 1
+
+// Файл индекса: заголовок, nodes узлов и ids номеров точек, всё в порядке байтов машины
+typedef struct {
+    char magic[8];          // HULL_INDEX_MAGIC без завершающего нуля
+    uint32_t version;       // HULL_INDEX_VERSION
+    uint32_t leaf;          // точек в листе
+    uint64_t count;         // число точек набора
+    uint64_t fingerprint;   // FNV-1a координат: индекс подходит только к своему набору
+    uint64_t nodes;         // узлов дерева: 2·L, где L — число листьев, округлённое вверх до степени двойки
+    uint64_t ids;           // всего номеров во всех узлах
+} HullIndexHeader;
+
+// Узел v (1 <= v < L — внутренний с детьми 2v и 2v + 1, L <= v — лист v - L): номера
+// ids[offset .. offset + count) по возрастанию
+typedef struct {
+    uint64_t offset;
+    uint32_t count;
+    uint32_t reserved;
+} HullIndexNode;
+
+typedef struct {
+    void* map;              // отображение файла индекса
+    size_t map_size;
+    const HullIndexHeader* header;
+    const HullIndexNode* nodes;
+    const uint32_t* ids;
+    int n;
+    int leaf;
+    int leaves;             // L
+} HullIndex;
+
+// Строит индекс для n точек xyz (оболочки узлов одного уровня — задачами пула) и записывает его
+// в path. В ids записывается общее число номеров в узлах. Возвращает NULL или текст ошибки
+// ("out of memory", если не выделилась память под узлы или задачи).
+const char* hull_index_build(const float (*xyz)[3], int n, ThreadPool* pool, const char* path, long long* ids);
+
+// Открывает индекс из path для набора xyz из n точек: файл отображается в память без копирования.
+// Возвращает NULL или текст ошибки (в том числе если индекс построен для другого набора).
+const char* hull_index_open(HullIndex* index, const char* path, const float (*xyz)[3], int n);
+void hull_index_close(HullIndex* index);
+
+// Треугольник наибольшей площади среди точек [l, r). Кандидаты собираются по индексу, перебор —
+// maxtri_find с настройками opts. В out->candidates — число вершин оболочки собранных точек,
+// номера в out->best — номера в наборе. Возвращает MAXTRI_OK или код ошибки.
+int hull_index_find(const HullIndex* index, const float (*xyz)[3], int l, int r, const maxtri_opts* opts,
+                    maxtri_result* out);
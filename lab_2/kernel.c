@@ -0,0 +1,374 @@
+// Все ядра считают одинаковую последовательность умножений и сложений, чтобы их результаты
+// совпадали побитово. AVX-512F и -march=native включают FMA, поэтому склейку запрещаем явно.
+#pragma GCC optimize("fp-contract=off")
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "kernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KERNEL_X86 1
+#endif
+
+static const char* const kernel_names[] = {"auto", "scalar", "sse2", "avx2", "avx512"};
+
+static void row_scalar(const PointsSoA* ps, int i, int j, int k_begin, int k_end,
+                       float* best, int* best_k) {
+    const float* x = ps->x;
+    const float* y = ps->y;
+    const float* z = ps->z;
+    float ax = x[j] - x[i];
+    float ay = y[j] - y[i];
+    float az = z[j] - z[i];
+    float local_best = *best;
+    int local_k = -1;
+    for (int k = k_begin; k < k_end; ++k) {
+        float bx = x[k] - x[i];
+        float by = y[k] - y[i];
+        float bz = z[k] - z[i];
+        float cx = ay * bz - az * by;
+        float cy = az * bx - ax * bz;
+        float cz = ax * by - ay * bx;
+        float s = cx * cx + cy * cy + cz * cz;
+        if (s > local_best) {
+            local_best = s;
+            local_k = k;
+        }
+    }
+    if (local_k >= 0) {
+        *best = local_best;
+        *best_k = local_k;
+    }
+}
+
+static void norms_scalar(const PointsSoA* ps, int i, int j, int k_begin, int k_end, float* out) {
+    const float* x = ps->x;
+    const float* y = ps->y;
+    const float* z = ps->z;
+    float ax = x[j] - x[i];
+    float ay = y[j] - y[i];
+    float az = z[j] - z[i];
+    for (int k = k_begin; k < k_end; ++k) {
+        float bx = x[k] - x[i];
+        float by = y[k] - y[i];
+        float bz = z[k] - z[i];
+        float cx = ay * bz - az * by;
+        float cy = az * bx - ax * bz;
+        float cz = ax * by - ay * bx;
+        out[k - k_begin] = cx * cx + cy * cy + cz * cz;
+    }
+}
+
+#ifdef KERNEL_X86
+
+// Свёртка лучших значений по дорожкам вектора: максимум, при равенстве меньший k
+static void reduce_lanes(const float* s, const int* k, int lanes, float* best, int* best_k) {
+    float lane_best = -1.0f;
+    int lane_k = -1;
+    for (int l = 0; l < lanes; ++l) {
+        if (k[l] < 0) continue;
+        if (s[l] > lane_best || (s[l] == lane_best && k[l] < lane_k)) {
+            lane_best = s[l];
+            lane_k = k[l];
+        }
+    }
+    if (lane_k >= 0 && lane_best > *best) {
+        *best = lane_best;
+        *best_k = lane_k;
+    }
+}
+
+static void row_sse2(const PointsSoA* ps, int i, int j, int k_begin, int k_end,
+                     float* best, int* best_k) {
+    const float* x = ps->x;
+    const float* y = ps->y;
+    const float* z = ps->z;
+    __m128 ix = _mm_set1_ps(x[i]), iy = _mm_set1_ps(y[i]), iz = _mm_set1_ps(z[i]);
+    __m128 ax = _mm_set1_ps(x[j] - x[i]);
+    __m128 ay = _mm_set1_ps(y[j] - y[i]);
+    __m128 az = _mm_set1_ps(z[j] - z[i]);
+    __m128 vbest = _mm_set1_ps(-1.0f);
+    __m128i vbest_k = _mm_set1_epi32(-1);
+    __m128i vk = _mm_setr_epi32(k_begin, k_begin + 1, k_begin + 2, k_begin + 3);
+    const __m128i step = _mm_set1_epi32(4);
+    int k = k_begin;
+    for (; k + 4 <= k_end; k += 4) {
+        __m128 bx = _mm_sub_ps(_mm_loadu_ps(x + k), ix);
+        __m128 by = _mm_sub_ps(_mm_loadu_ps(y + k), iy);
+        __m128 bz = _mm_sub_ps(_mm_loadu_ps(z + k), iz);
+        __m128 cx = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by));
+        __m128 cy = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz));
+        __m128 cz = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx));
+        __m128 s = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)), _mm_mul_ps(cz, cz));
+        __m128 gt = _mm_cmpgt_ps(s, vbest);
+        __m128i gti = _mm_castps_si128(gt);
+        vbest = _mm_or_ps(_mm_and_ps(gt, s), _mm_andnot_ps(gt, vbest));
+        vbest_k = _mm_or_si128(_mm_and_si128(gti, vk), _mm_andnot_si128(gti, vbest_k));
+        vk = _mm_add_epi32(vk, step);
+    }
+    float lane_s[4];
+    int lane_k[4];
+    _mm_storeu_ps(lane_s, vbest);
+    _mm_storeu_si128((__m128i*)lane_k, vbest_k);
+    reduce_lanes(lane_s, lane_k, 4, best, best_k);
+    row_scalar(ps, i, j, k, k_end, best, best_k);
+}
+
+__attribute__((target("avx2")))
+static void row_avx2(const PointsSoA* ps, int i, int j, int k_begin, int k_end,
+                     float* best, int* best_k) {
+    const float* x = ps->x;
+    const float* y = ps->y;
+    const float* z = ps->z;
+    __m256 ix = _mm256_set1_ps(x[i]), iy = _mm256_set1_ps(y[i]), iz = _mm256_set1_ps(z[i]);
+    __m256 ax = _mm256_set1_ps(x[j] - x[i]);
+    __m256 ay = _mm256_set1_ps(y[j] - y[i]);
+    __m256 az = _mm256_set1_ps(z[j] - z[i]);
+    __m256 vbest = _mm256_set1_ps(-1.0f);
+    __m256i vbest_k = _mm256_set1_epi32(-1);
+    __m256i vk = _mm256_add_epi32(_mm256_set1_epi32(k_begin), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    const __m256i step = _mm256_set1_epi32(8);
+    int k = k_begin;
+    for (; k + 8 <= k_end; k += 8) {
+        __m256 bx = _mm256_sub_ps(_mm256_loadu_ps(x + k), ix);
+        __m256 by = _mm256_sub_ps(_mm256_loadu_ps(y + k), iy);
+        __m256 bz = _mm256_sub_ps(_mm256_loadu_ps(z + k), iz);
+        __m256 cx = _mm256_sub_ps(_mm256_mul_ps(ay, bz), _mm256_mul_ps(az, by));
+        __m256 cy = _mm256_sub_ps(_mm256_mul_ps(az, bx), _mm256_mul_ps(ax, bz));
+        __m256 cz = _mm256_sub_ps(_mm256_mul_ps(ax, by), _mm256_mul_ps(ay, bx));
+        __m256 s = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, cx), _mm256_mul_ps(cy, cy)),
+                                 _mm256_mul_ps(cz, cz));
+        __m256 gt = _mm256_cmp_ps(s, vbest, _CMP_GT_OQ);
+        vbest = _mm256_blendv_ps(vbest, s, gt);
+        vbest_k = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(vbest_k),
+                                                       _mm256_castsi256_ps(vk), gt));
+        vk = _mm256_add_epi32(vk, step);
+    }
+    float lane_s[8];
+    int lane_k[8];
+    _mm256_storeu_ps(lane_s, vbest);
+    _mm256_storeu_si256((__m256i*)lane_k, vbest_k);
+    reduce_lanes(lane_s, lane_k, 8, best, best_k);
+    row_scalar(ps, i, j, k, k_end, best, best_k);
+}
+
+__attribute__((target("avx512f")))
+static void row_avx512(const PointsSoA* ps, int i, int j, int k_begin, int k_end,
+                       float* best, int* best_k) {
+    const float* x = ps->x;
+    const float* y = ps->y;
+    const float* z = ps->z;
+    __m512 ix = _mm512_set1_ps(x[i]), iy = _mm512_set1_ps(y[i]), iz = _mm512_set1_ps(z[i]);
+    __m512 ax = _mm512_set1_ps(x[j] - x[i]);
+    __m512 ay = _mm512_set1_ps(y[j] - y[i]);
+    __m512 az = _mm512_set1_ps(z[j] - z[i]);
+    __m512 vbest = _mm512_set1_ps(-1.0f);
+    __m512i vbest_k = _mm512_set1_epi32(-1);
+    __m512i vk = _mm512_add_epi32(_mm512_set1_epi32(k_begin),
+                                  _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    const __m512i step = _mm512_set1_epi32(16);
+    int k = k_begin;
+    for (; k + 16 <= k_end; k += 16) {
+        __m512 bx = _mm512_sub_ps(_mm512_loadu_ps(x + k), ix);
+        __m512 by = _mm512_sub_ps(_mm512_loadu_ps(y + k), iy);
+        __m512 bz = _mm512_sub_ps(_mm512_loadu_ps(z + k), iz);
+        __m512 cx = _mm512_sub_ps(_mm512_mul_ps(ay, bz), _mm512_mul_ps(az, by));
+        __m512 cy = _mm512_sub_ps(_mm512_mul_ps(az, bx), _mm512_mul_ps(ax, bz));
+        __m512 cz = _mm512_sub_ps(_mm512_mul_ps(ax, by), _mm512_mul_ps(ay, bx));
+        __m512 s = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(cx, cx), _mm512_mul_ps(cy, cy)),
+                                 _mm512_mul_ps(cz, cz));
+        __mmask16 gt = _mm512_cmp_ps_mask(s, vbest, _CMP_GT_OQ);
+        vbest = _mm512_mask_blend_ps(gt, vbest, s);
+        vbest_k = _mm512_mask_blend_epi32(gt, vbest_k, vk);
+        vk = _mm512_add_epi32(vk, step);
+    }
+    float lane_s[16];
+    int lane_k[16];
+    _mm512_storeu_ps(lane_s, vbest);
+    _mm512_storeu_si512(lane_k, vbest_k);
+    reduce_lanes(lane_s, lane_k, 16, best, best_k);
+    row_scalar(ps, i, j, k, k_end, best, best_k);
+}
+
+static void norms_sse2(const PointsSoA* ps, int i, int j, int k_begin, int k_end, float* out) {
+    const float* x = ps->x;
+    const float* y = ps->y;
+    const float* z = ps->z;
+    __m128 ix = _mm_set1_ps(x[i]), iy = _mm_set1_ps(y[i]), iz = _mm_set1_ps(z[i]);
+    __m128 ax = _mm_set1_ps(x[j] - x[i]);
+    __m128 ay = _mm_set1_ps(y[j] - y[i]);
+    __m128 az = _mm_set1_ps(z[j] - z[i]);
+    int k = k_begin;
+    for (; k + 4 <= k_end; k += 4) {
+        __m128 bx = _mm_sub_ps(_mm_loadu_ps(x + k), ix);
+        __m128 by = _mm_sub_ps(_mm_loadu_ps(y + k), iy);
+        __m128 bz = _mm_sub_ps(_mm_loadu_ps(z + k), iz);
+        __m128 cx = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by));
+        __m128 cy = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz));
+        __m128 cz = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx));
+        __m128 s = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)), _mm_mul_ps(cz, cz));
+        _mm_storeu_ps(out + (k - k_begin), s);
+    }
+    norms_scalar(ps, i, j, k, k_end, out + (k - k_begin));
+}
+
+__attribute__((target("avx2")))
+static void norms_avx2(const PointsSoA* ps, int i, int j, int k_begin, int k_end, float* out) {
+    const float* x = ps->x;
+    const float* y = ps->y;
+    const float* z = ps->z;
+    __m256 ix = _mm256_set1_ps(x[i]), iy = _mm256_set1_ps(y[i]), iz = _mm256_set1_ps(z[i]);
+    __m256 ax = _mm256_set1_ps(x[j] - x[i]);
+    __m256 ay = _mm256_set1_ps(y[j] - y[i]);
+    __m256 az = _mm256_set1_ps(z[j] - z[i]);
+    int k = k_begin;
+    for (; k + 8 <= k_end; k += 8) {
+        __m256 bx = _mm256_sub_ps(_mm256_loadu_ps(x + k), ix);
+        __m256 by = _mm256_sub_ps(_mm256_loadu_ps(y + k), iy);
+        __m256 bz = _mm256_sub_ps(_mm256_loadu_ps(z + k), iz);
+        __m256 cx = _mm256_sub_ps(_mm256_mul_ps(ay, bz), _mm256_mul_ps(az, by));
+        __m256 cy = _mm256_sub_ps(_mm256_mul_ps(az, bx), _mm256_mul_ps(ax, bz));
+        __m256 cz = _mm256_sub_ps(_mm256_mul_ps(ax, by), _mm256_mul_ps(ay, bx));
+        __m256 s = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, cx), _mm256_mul_ps(cy, cy)),
+                                 _mm256_mul_ps(cz, cz));
+        _mm256_storeu_ps(out + (k - k_begin), s);
+    }
+    norms_scalar(ps, i, j, k, k_end, out + (k - k_begin));
+}
+
+__attribute__((target("avx512f")))
+static void norms_avx512(const PointsSoA* ps, int i, int j, int k_begin, int k_end, float* out) {
+    const float* x = ps->x;
+    const float* y = ps->y;
+    const float* z = ps->z;
+    __m512 ix = _mm512_set1_ps(x[i]), iy = _mm512_set1_ps(y[i]), iz = _mm512_set1_ps(z[i]);
+    __m512 ax = _mm512_set1_ps(x[j] - x[i]);
+    __m512 ay = _mm512_set1_ps(y[j] - y[i]);
+    __m512 az = _mm512_set1_ps(z[j] - z[i]);
+    int k = k_begin;
+    for (; k + 16 <= k_end; k += 16) {
+        __m512 bx = _mm512_sub_ps(_mm512_loadu_ps(x + k), ix);
+        __m512 by = _mm512_sub_ps(_mm512_loadu_ps(y + k), iy);
+        __m512 bz = _mm512_sub_ps(_mm512_loadu_ps(z + k), iz);
+        __m512 cx = _mm512_sub_ps(_mm512_mul_ps(ay, bz), _mm512_mul_ps(az, by));
+        __m512 cy = _mm512_sub_ps(_mm512_mul_ps(az, bx), _mm512_mul_ps(ax, bz));
+        __m512 cz = _mm512_sub_ps(_mm512_mul_ps(ax, by), _mm512_mul_ps(ay, bx));
+        __m512 s = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(cx, cx), _mm512_mul_ps(cy, cy)),
+                                 _mm512_mul_ps(cz, cz));
+        _mm512_storeu_ps(out + (k - k_begin), s);
+    }
+    norms_scalar(ps, i, j, k, k_end, out + (k - k_begin));
+}
+
+#endif
+
+int kernel_parse(const char* name) {
+    for (int kind = 0; kind < (int)(sizeof(kernel_names) / sizeof(kernel_names[0])); ++kind) {
+        if (strcmp(name, kernel_names[kind]) == 0) {
+            return kind;
+        }
+    }
+    return -1;
+}
+
+static KernelKind kernel_resolve(KernelKind kind) {
+    if (kind != KERNEL_AUTO) {
+        return kind;
+    }
+#ifdef KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return KERNEL_AVX512;
+    if (__builtin_cpu_supports("avx2")) return KERNEL_AVX2;
+    return KERNEL_SSE2;
+#else
+    return KERNEL_SCALAR;
+#endif
+}
+
+RowKernel kernel_get(KernelKind kind) {
+    kind = kernel_resolve(kind);
+    switch (kind) {
+    case KERNEL_SCALAR:
+        return row_scalar;
+#ifdef KERNEL_X86
+    case KERNEL_SSE2:
+        return row_sse2;
+    case KERNEL_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? row_avx2 : NULL;
+    case KERNEL_AVX512:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f") ? row_avx512 : NULL;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+NormKernel kernel_norms_get(KernelKind kind) {
+    kind = kernel_resolve(kind);
+    switch (kind) {
+    case KERNEL_SCALAR:
+        return norms_scalar;
+#ifdef KERNEL_X86
+    case KERNEL_SSE2:
+        return norms_sse2;
+    case KERNEL_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? norms_avx2 : NULL;
+    case KERNEL_AVX512:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f") ? norms_avx512 : NULL;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+const char* kernel_name(KernelKind kind) {
+    return kernel_names[kernel_resolve(kind)];
+}
+
+void kernel_tile_sizes(int* tile_j, int* tile_k) {
+    long l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+    long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (l1 <= 0) l1 = 32 * 1024;
+    if (l2 <= 0) {
+        // Без сведений об L2 берём долю L3 или типичные 256 КБ
+        long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+        l2 = l3 > 0 ? l3 / 8 : 256 * 1024;
+    }
+    // Точка занимает три float в массивах x, y, z; пара (i, j) — ещё лучший квадрат и его k
+    *tile_k = (int)(l2 / 2 / (3 * sizeof(float)));
+    *tile_j = (int)(l1 / 2 / (3 * sizeof(float) + sizeof(float) + sizeof(int)));
+}
+
+int points_soa_init(PointsSoA* ps, const float (*xyz)[3], const int* ids, int n) {
+    // Выравнивание под строку кэша и запас до кратного 64 байтам размера
+    size_t bytes = ((size_t)n * sizeof(float) + 63) / 64 * 64;
+    ps->x = aligned_alloc(64, bytes);
+    ps->y = aligned_alloc(64, bytes);
+    ps->z = aligned_alloc(64, bytes);
+    ps->n = n;
+    if (!ps->x || !ps->y || !ps->z) {
+        points_soa_free(ps);
+        return -1;
+    }
+    for (int i = 0; i < n; ++i) {
+        const float* p = xyz[ids ? ids[i] : i];
+        ps->x[i] = p[0];
+        ps->y[i] = p[1];
+        ps->z[i] = p[2];
+    }
+    return 0;
+}
+
+void points_soa_free(PointsSoA* ps) {
+    free(ps->x);
+    free(ps->y);
+    free(ps->z);
+    ps->x = ps->y = ps->z = NULL;
+    ps->n = 0;
+}
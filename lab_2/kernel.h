@@ -0,0 +1,50 @@
+#pragma once
+
+// Точки в виде структуры массивов: координаты лежат подряд, и внутренний цикл
+// перебора читает их векторами.
+typedef struct {
+    float* x;
+    float* y;
+    float* z;
+    int n;
+} PointsSoA;
+
+// Перебор третьей вершины k из [k_begin, k_end) при фиксированных i и j.
+// Сравниваются квадраты нормы векторного произведения (p_j - p_i) x (p_k - p_i),
+// корень извлекается только у итогового ответа. Если лучший квадрат строго больше *best,
+// он записывается в *best, а его k (наименьший при равенстве) — в *best_k.
+typedef void (*RowKernel)(const PointsSoA* ps, int i, int j, int k_begin, int k_end,
+                          float* best, int* best_k);
+
+// То же без отбора: квадраты для всех k из [k_begin, k_end) записываются в out[k - k_begin].
+// Значения побитово совпадают с теми, что сравнивает RowKernel.
+typedef void (*NormKernel)(const PointsSoA* ps, int i, int j, int k_begin, int k_end, float* out);
+
+typedef enum {
+    KERNEL_AUTO,
+    KERNEL_SCALAR,
+    KERNEL_SSE2,
+    KERNEL_AVX2,
+    KERNEL_AVX512
+} KernelKind;
+
+// Разбор имени ядра ("auto", "scalar", "sse2", "avx2", "avx512"), -1 — неизвестное имя
+int kernel_parse(const char* name);
+
+// Ядро нужного вида; для KERNEL_AUTO — самое широкое из поддерживаемых процессором.
+// NULL, если процессор не поддерживает запрошенный набор инструкций.
+RowKernel kernel_get(KernelKind kind);
+
+// Ядро без отбора того же вида, что и kernel_get(kind)
+NormKernel kernel_norms_get(KernelKind kind);
+
+// Имя ядра, которое вернёт kernel_get(kind)
+const char* kernel_name(KernelKind kind);
+
+// Размеры блоков для обхода с разбиением на блоки по размерам кэшей из sysconf:
+// блок третьих вершин занимает половину L2, состояние блока пар (i, j) — половину L1.
+void kernel_tile_sizes(int* tile_j, int* tile_k);
+
+// Копия точек xyz[ids[0]], ..., xyz[ids[n-1]] (ids == NULL — первых n точек) в виде структуры массивов
+int points_soa_init(PointsSoA* ps, const float (*xyz)[3], const int* ids, int n);
+void points_soa_free(PointsSoA* ps);
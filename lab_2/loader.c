@@ -0,0 +1,317 @@
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "loader.h"
+
+static __thread char error_buf[256];
+
+// Часть текстового файла для разбора в отдельном потоке
+typedef struct {
+    const char* begin;
+    const char* end;
+    int skip_header;   // первая часть файла: первая строка может быть заголовком
+    int scalar_size;
+    int dim;           // по первой точке части; 0 — точек нет
+    char* values;      // точки по dim координат размера scalar_size
+    long long count, cap;
+    long long lines;   // число строк в части
+    long long bad_line; // номер первой ошибочной строки внутри части, -1 — ошибок нет
+    int no_memory;
+} TextPart;
+
+// Разбирает строку [begin, end) в out: strtof для float32, strtod для float64, чтобы значения
+// совпадали с прямым разбором в этот тип. Число координат (2 или 3), 0 — пустая строка
+// или комментарий, -1 — ошибка (в том числе nan и inf, которые strtof/strtod принимают).
+static int parse_values(const char* begin, const char* end, int scalar_size, double* out) {
+    char line[256];
+    size_t len = end - begin;
+    if (len >= sizeof(line)) {
+        return -1;
+    }
+    memcpy(line, begin, len);
+    line[len] = '\0';
+
+    char* p = line;
+    while (*p == ' ' || *p == '\t' || *p == '\r') ++p;
+    if (*p == '\0' || *p == '#') {
+        return 0;
+    }
+    int count = 0;
+    while (count < 3) {
+        while (*p == ' ' || *p == '\t' || *p == ',' || *p == ';') ++p;
+        if (count == 2 && (*p == '\0' || *p == '\r')) {
+            break;
+        }
+        char* endptr;
+        out[count] = scalar_size == sizeof(float) ? strtof(p, &endptr) : strtod(p, &endptr);
+        if (endptr == p || !isfinite(out[count])) {
+            return -1;
+        }
+        p = endptr;
+        ++count;
+    }
+    while (*p == ' ' || *p == '\t' || *p == ',' || *p == ';' || *p == '\r') ++p;
+    return *p == '\0' ? count : -1;
+}
+
+int points_parse_line(const char* begin, const char* end, float* out) {
+    double values[3];
+    int count = parse_values(begin, end, sizeof(float), values);
+    if (count <= 0) {
+        return count;
+    }
+    if (count != 3) {
+        return -1;
+    }
+    for (int c = 0; c < 3; ++c) {
+        out[c] = (float)values[c];
+    }
+    return 1;
+}
+
+static void ParseText(void* arg) {
+    TextPart* part = (TextPart*) arg;
+    size_t point_size = 3 * part->scalar_size;
+    part->cap = (part->end - part->begin) / 16 + 16;
+    part->values = malloc(part->cap * point_size);
+    if (part->values == NULL) {
+        part->no_memory = 1;
+        return;
+    }
+    const char* p = part->begin;
+    while (p < part->end) {
+        const char* eol = memchr(p, '\n', part->end - p);
+        if (eol == NULL) eol = part->end;
+        double point[3];
+        int count = parse_values(p, eol, part->scalar_size, point);
+        if (count > 0 && part->dim == 0) {
+            part->dim = count;
+            point_size = count * part->scalar_size;
+        }
+        if ((count < 0 || (count > 0 && count != part->dim)) && !(part->skip_header && part->lines == 0)) {
+            part->bad_line = part->lines;
+            return;
+        }
+        if (count > 0 && count == part->dim) {
+            if (part->count == part->cap) {
+                char* grown = realloc(part->values, part->cap * 2 * point_size);
+                if (grown == NULL) {
+                    part->no_memory = 1;
+                    return;
+                }
+                part->values = grown;
+                part->cap *= 2;
+            }
+            char* out = part->values + part->count++ * point_size;
+            for (int c = 0; c < count; ++c) {
+                if (part->scalar_size == sizeof(float)) {
+                    float value = (float)point[c];
+                    memcpy(out + c * sizeof(float), &value, sizeof(float));
+                } else {
+                    memcpy(out + c * sizeof(double), &point[c], sizeof(double));
+                }
+            }
+        }
+        ++part->lines;
+        p = eol + 1;
+    }
+}
+
+// Номер первой точки с nan или inf в координатах, -1 — все конечны
+static long long first_non_finite(const void* data, long long count, int dim, int scalar_size) {
+    for (long long v = 0; v < count * dim; ++v) {
+        double value = scalar_size == sizeof(float) ? ((const float*)data)[v] : ((const double*)data)[v];
+        if (!isfinite(value)) {
+            return v / dim;
+        }
+    }
+    return -1;
+}
+
+static void set_layout(PointSet* set, int dim, int scalar_size, const void* data, int n) {
+    set->dim = dim;
+    set->scalar_size = scalar_size;
+    set->data = data;
+    set->n = n;
+    set->xyz = dim == 3 && scalar_size == sizeof(float) ? (const float (*)[3])data : NULL;
+}
+
+static const char* load_text(const char* data, size_t size, ThreadPool* pool, int scalar_size, PointSet* set) {
+    int parts_count = pool ? pool_workers(pool) : 1;
+    if ((size_t)parts_count > size / 65536 + 1) {
+        parts_count = size / 65536 + 1;
+    }
+
+    // Границы частей сдвигаются к началу следующей строки
+    TextPart* parts = calloc(parts_count, sizeof(TextPart));
+    if (parts == NULL) {
+        return "out of memory";
+    }
+    const char* begin = data;
+    for (int t = 0; t < parts_count; ++t) {
+        const char* end = data + size * (t + 1) / parts_count;
+        if (end < begin) end = begin;
+        const char* eol = end < data + size ? memchr(end, '\n', data + size - end) : NULL;
+        end = eol ? eol + 1 : data + size;
+        parts[t].begin = begin;
+        parts[t].end = end;
+        parts[t].skip_header = (t == 0);
+        parts[t].scalar_size = scalar_size;
+        parts[t].bad_line = -1;
+        begin = end;
+    }
+
+    if (pool && parts_count > 1) {
+        TaskGroup group = {0};
+        for (int t = 0; t < parts_count; ++t) {
+            pool_submit(pool, &group, ParseText, &parts[t]);
+        }
+        pool_wait(pool, &group);
+    } else {
+        for (int t = 0; t < parts_count; ++t) {
+            ParseText(&parts[t]);
+        }
+    }
+
+    const char* error = NULL;
+    long long total = 0, lines = 0;
+    int dim = 0;
+    for (int t = 0; t < parts_count && error == NULL; ++t) {
+        if (parts[t].no_memory) {
+            error = "out of memory";
+        } else if (parts[t].bad_line >= 0) {
+            snprintf(error_buf, sizeof(error_buf), "invalid point at line %lld", lines + parts[t].bad_line + 1);
+            error = error_buf;
+        } else if (parts[t].dim != 0 && dim != 0 && parts[t].dim != dim) {
+            snprintf(error_buf, sizeof(error_buf), "%dD point at line %lld after %dD points",
+                     parts[t].dim, lines + 1, dim);
+            error = error_buf;
+        }
+        if (dim == 0) dim = parts[t].dim;
+        total += parts[t].count;
+        lines += parts[t].lines;
+    }
+    if (error == NULL && total > INT_MAX) {
+        error = "too many points";
+    }
+    if (error == NULL) {
+        // Пустой файл считается набором трёхмерных точек
+        if (dim == 0) dim = 3;
+        size_t point_size = dim * scalar_size;
+        set->owned = malloc((total > 0 ? total : 1) * point_size);
+        if (set->owned == NULL) {
+            error = "out of memory";
+        }
+        size_t offset = 0;
+        for (int t = 0; t < parts_count && error == NULL; ++t) {
+            memcpy((char*)set->owned + offset, parts[t].values, parts[t].count * point_size);
+            offset += parts[t].count * point_size;
+        }
+        if (error == NULL) {
+            set_layout(set, dim, scalar_size, set->owned, (int)total);
+        }
+    }
+    for (int t = 0; t < parts_count; ++t) {
+        free(parts[t].values);
+    }
+    free(parts);
+    return error;
+}
+
+const char* points_load(const char* path, ThreadPool* pool, PointSet* set) {
+    return points_load_as(path, pool, sizeof(float), set);
+}
+
+const char* points_load_as(const char* path, ThreadPool* pool, int text_scalar_size, PointSet* set) {
+    memset(set, 0, sizeof(PointSet));
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return "failed to open file";
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return "failed to stat file";
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return "file is empty";
+    }
+    size_t size = st.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return "failed to map file";
+    }
+    // Файл читается один раз подряд: ядро может читать с упреждением и сразу освобождать страницы
+    madvise(map, size, MADV_SEQUENTIAL);
+
+    const PointsHeader* header = map;
+    if (size >= sizeof(PointsHeader) && memcmp(header->magic, POINTS_MAGIC, sizeof(header->magic)) == 0) {
+        const char* error = NULL;
+        if (header->version != POINTS_VERSION) {
+            error = "unsupported binary format version";
+        } else if ((header->dim != 2 && header->dim != 3)
+                   || (header->scalar_size != sizeof(float) && header->scalar_size != sizeof(double))) {
+            error = "only 2D and 3D float32 or float64 points are supported";
+        } else if (header->count > INT_MAX) {
+            error = "too many points";
+        } else if ((size - sizeof(PointsHeader)) / (header->dim * header->scalar_size) < header->count) {
+            error = "file is shorter than its header says";
+        } else {
+            long long bad = first_non_finite((const char*)map + sizeof(PointsHeader), (long long)header->count,
+                                             header->dim, header->scalar_size);
+            if (bad >= 0) {
+                snprintf(error_buf, sizeof(error_buf), "non-finite coordinate in point %lld", bad);
+                error = error_buf;
+            }
+        }
+        if (error != NULL) {
+            munmap(map, size);
+            return error;
+        }
+        set_layout(set, header->dim, header->scalar_size, (const char*)map + sizeof(PointsHeader), (int)header->count);
+        set->map = map;
+        set->map_size = size;
+        return NULL;
+    }
+
+    const char* error = load_text(map, size, pool, text_scalar_size, set);
+    munmap(map, size);
+    return error;
+}
+
+void points_unload(PointSet* set) {
+    if (set->map != NULL) {
+        munmap(set->map, set->map_size);
+    }
+    free(set->owned);
+    memset(set, 0, sizeof(PointSet));
+}
+
+const char* points_save(const char* path, const float (*xyz)[3], int n) {
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) {
+        return "failed to create file";
+    }
+    PointsHeader header = {0};
+    memcpy(header.magic, POINTS_MAGIC, sizeof(header.magic));
+    header.version = POINTS_VERSION;
+    header.dim = 3;
+    header.scalar_size = sizeof(float);
+    header.count = n;
+    int ok = fwrite(&header, sizeof(header), 1, f) == 1
+          && fwrite(xyz, 3 * sizeof(float), n, f) == (size_t)n;
+    if (fclose(f) != 0) {
+        ok = 0;
+    }
+    return ok ? NULL : "failed to write file";
+}
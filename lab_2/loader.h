@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include "pool.h"
+
+// Двоичный формат набора точек: заголовок и следом count точек по dim координат (x, y[, z])
+// размера scalar_size в порядке байтов машины, без выравнивания между точками.
+#define POINTS_MAGIC "MAXTRI3D"
+#define POINTS_VERSION 1
+
+typedef struct {
+    char magic[8];        // POINTS_MAGIC без завершающего нуля
+    uint32_t version;     // POINTS_VERSION
+    uint32_t dim;         // число координат точки: 2 или 3
+    uint32_t scalar_size; // размер координаты в байтах: 4 (float32) или 8 (float64)
+    uint32_t reserved;
+    uint64_t count;       // число точек
+} PointsHeader;
+
+typedef struct {
+    const float (*xyz)[3]; // точки 3D float32; NULL для других размерностей и типов
+    int n;
+    void* map;         // отображение двоичного файла (точки читаются прямо из него)
+    size_t map_size;
+    void* owned;       // точки, разобранные из текстового файла
+    int dim;           // 2 или 3
+    int scalar_size;   // 4 (float32) или 8 (float64)
+    const void* data;  // n точек по dim координат подряд
+} PointSet;
+
+// Загружает точки из файла. Двоичный файл (узнаётся по POINTS_MAGIC) отображается в память
+// без копирования, текстовый (по два или три числа в строке, одинаково во всём файле, через пробелы,
+// табуляции или запятые, пустые строки и строки с # пропускаются, первая строка может быть
+// заголовком) разбирается частями параллельно на потоках пула в float32.
+// Возвращает NULL или текст ошибки.
+const char* points_load(const char* path, ThreadPool* pool, PointSet* set);
+
+// То же, но текстовый файл разбирается в координаты размера text_scalar_size (4 или 8)
+const char* points_load_as(const char* path, ThreadPool* pool, int text_scalar_size, PointSet* set);
+
+void points_unload(PointSet* set);
+
+// Разбирает строку текстового формата [begin, end): 1 — точка записана в out,
+// 0 — пустая строка или комментарий, -1 — ошибка
+int points_parse_line(const char* begin, const char* end, float* out);
+
+// Записывает точки в двоичном формате. Возвращает NULL или текст ошибки.
+const char* points_save(const char* path, const float (*xyz)[3], int n);
@@ -1,160 +1,745 @@
 #define _POSIX_C_SOURCE 199309L
 
-#include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
-#include <math.h>
-#include <sys/time.h>
 #include <time.h>
 #include <limits.h>
+#include <string.h>
+#include <getopt.h>
+#include <errno.h>
 #include "coordinates.h"
+#include "kernel.h"
+#include "pool.h"
+#include "loader.h"
+#include "maxtri.h"
+#include "dist.h"
+#include "procs.h"
+#include "coreset.h"
+#include "hullindex.h"
+#include "stream.h"
+#include "batch.h"
 
-float max_area = 0.0;
-int max_i = -1, max_j = -1, max_k = -1;
-
-typedef struct {
-    int start;
-    int points_count;
-    int threads_count;
-} ThreadArgs;
-
-typedef struct {
-    float area;
-    int i, j, k;
-} Result;
-
-void* FindTriangle(void* arg) {
-    ThreadArgs* args = (ThreadArgs*) arg;
-    int start = args->start;
-    int n = args->points_count;
-    int ths = args->threads_count;
-    float local_max = 0.0;
-    int local_i = -1, local_j = -1, local_k = -1;
-    for (int i = start; i < n - 2; i += ths) {
-        for (int j = i + 1; j < n - 1; ++j) {
-            for (int k = j + 1; k < n; ++k) {
-                // Считаем площадь
-                float ax = coordinates[j][0] - coordinates[i][0];
-                float ay = coordinates[j][1] - coordinates[i][1];
-                float az = coordinates[j][2] - coordinates[i][2];
-                float bx = coordinates[k][0] - coordinates[i][0];
-                float by = coordinates[k][1] - coordinates[i][1];
-                float bz = coordinates[k][2] - coordinates[i][2];
-                float cx = ay * bz - az * by;
-                float cy = az * bx - ax * bz;
-                float cz = ax * by - ay * bx;
-                float area = 0.5 * sqrt(cx*cx + cy*cy + cz*cz);
-                if (area > local_max) {
-                    local_max = area;
-                    local_i = i;
-                    local_j = j;
-                    local_k = k;
-                }
-            }
-        }
+static void usage(const char* prog) {
+    printf("Usage: %s [--hull] [--kernel auto|scalar|sse2|avx2|avx512] [--pin none|compact|scatter] [--input file] [--tile k] [--no-prune] [--quantize] [--perf] [--deadline ms] [--progress ms] [--objective area|perimeter|min-area] [--double] [--approx eps] [--top K] [--coordinator port | --worker host:port] [--procs N] [--pool-threads N] [--coreset g] [--build-index file | --index file [--range l:r,...|-]] [--stream file|-] [--batch dir|manifest] <num_threads|auto> [num_points]\n", prog);
+}
+
+// "l:r" или "l r" в l и r; 0 — разобрано, -1 — ошибка. *end — за последним символом диапазона.
+static int parse_range(const char* text, int* l, int* r, const char** end) {
+    char* endptr;
+    errno = 0;
+    long l_long = strtol(text, &endptr, 10);
+    if (endptr == text || (*endptr != ':' && *endptr != ' ' && *endptr != '\t')) {
+        return -1;
+    }
+    const char* p = endptr + 1;
+    long r_long = strtol(p, &endptr, 10);
+    if (endptr == p || errno != 0 || l_long < 0 || l_long > INT_MAX || r_long < 0 || r_long > INT_MAX) {
+        return -1;
     }
-    Result* res = malloc(sizeof(Result));
-    res->area = local_max;
-    res->i = local_i;
-    res->j = local_j;
-    res->k = local_k;
-    return res;
+    *l = (int)l_long;
+    *r = (int)r_long;
+    *end = endptr;
+    return 0;
 }
 
-void sequential_find(int n) {
-    for (int i = 0; i < n - 2; ++i) {
-        for (int j = i + 1; j < n - 1; ++j) {
-            for (int k = j + 1; k < n; ++k) {
-                float ax = coordinates[j][0] - coordinates[i][0];
-                float ay = coordinates[j][1] - coordinates[i][1];
-                float az = coordinates[j][2] - coordinates[i][2];
-                float bx = coordinates[k][0] - coordinates[i][0];
-                float by = coordinates[k][1] - coordinates[i][1];
-                float bz = coordinates[k][2] - coordinates[i][2];
-                float cx = ay * bz - az * by;
-                float cy = az * bx - ax * bz;
-                float cz = ax * by - ay * bx;
-                float area = 0.5 * sqrt(cx*cx + cy*cy + cz*cz);
-                if (area > max_area) {
-                    max_area = area;
-                    max_i = i;
-                    max_j = j;
-                    max_k = k;
-                }
+// Один запрос по индексу; 0 — ответ выведен, -1 — диапазон неверен или поиск не удался
+static int run_range(const HullIndex* index, const float (*xyz)[3], int l, int r, const maxtri_opts* opts) {
+    if (l < 0 || r > index->n || r - l < 3) {
+        printf("Range [%d, %d) is invalid: need 0 <= l and l + 3 <= r <= %d\n", l, r, index->n);
+        return -1;
+    }
+    struct timespec start, end;
+    maxtri_result result;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int status = hull_index_find(index, xyz, l, r, opts, &result);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (status != MAXTRI_OK) {
+        printf("Range [%d, %d): search failed: %s\n", l, r, maxtri_strerror(status));
+        return -1;
+    }
+    double ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+    printf("Range [%d, %d): max area %.2f at points %d, %d, %d (%d candidates, %.3f ms)\n", l, r,
+           result.best.area, result.best.i, result.best.j, result.best.k, result.candidates, ms);
+    maxtri_result_free(&result);
+    return 0;
+}
+
+// Доля события на тройку или на такт; n/a, если счётчик недоступен
+static void print_ratio(const char* name, long long value, long long base) {
+    if (value < 0 || base <= 0) {
+        printf(", %s n/a", name);
+    } else {
+        printf(", %s %.4g", name, (double)value / base);
+    }
+}
+
+static void print_perf_line(const char* label, const PerfSample* sample, long long wall_ns, int counters) {
+    printf("%s: busy %lld ms, idle %lld ms, %lld triples", label, sample->busy_ns / 1000000,
+           (wall_ns - sample->busy_ns > 0 ? wall_ns - sample->busy_ns : 0) / 1000000, sample->triples);
+    if (!counters) {
+        printf("\n");
+        return;
+    }
+    if (sample->counts[PERF_CYCLES] > 0 && sample->counts[PERF_INSTRUCTIONS] >= 0) {
+        printf(", IPC %.2f", (double)sample->counts[PERF_INSTRUCTIONS] / sample->counts[PERF_CYCLES]);
+    } else {
+        printf(", IPC n/a");
+    }
+    print_ratio("L1D misses/triple", sample->counts[PERF_L1D_MISSES], sample->triples);
+    print_ratio("LLC misses/triple", sample->counts[PERF_LLC_MISSES], sample->triples);
+    print_ratio("branch misses/triple", sample->counts[PERF_BRANCH_MISSES], sample->triples);
+    printf("\n");
+}
+
+static void print_progress(const maxtri_progress* progress, void* arg) {
+    (void)arg;
+    printf("Progress at %.0f ms: %.1f%% of triples, area %.2f\n", progress->elapsed_ms,
+           progress->coverage * 100.0, progress->area);
+    fflush(stdout);
+}
+
+// Задачи перебора по отдельности и сумма; простой — время перебора, в которое задача не работала
+static void print_perf(const maxtri_result* result) {
+    PerfSample total;
+    perf_sample_init(&total);
+    int error = 0;
+    int counters = 0;
+    for (int t = 0; t < result->perf_count; ++t) {
+        for (int e = 0; e < PERF_EVENTS; ++e) {
+            counters |= result->perf[t].counts[e] >= 0;
+        }
+    }
+    for (int t = 0; t < result->perf_count; ++t) {
+        const PerfSample* sample = &result->perf[t];
+        char label[32];
+        snprintf(label, sizeof(label), "Perf task %d", t);
+        print_perf_line(label, sample, result->perf_wall_ns, counters);
+        total.busy_ns += sample->busy_ns;
+        total.triples += sample->triples;
+        for (int e = 0; e < PERF_EVENTS; ++e) {
+            if (sample->counts[e] >= 0) {
+                total.counts[e] = (total.counts[e] < 0 ? 0 : total.counts[e]) + sample->counts[e];
             }
         }
+        if (error == 0) error = sample->error;
+    }
+    if (result->perf_count > 1) {
+        print_perf_line("Perf total", &total, result->perf_wall_ns * result->perf_count, counters);
+    }
+    if (error != 0) {
+        // Без доступа ядро отвечает EACCES или EPERM, без поддержки события — ENOENT или EOPNOTSUPP
+        printf("%s performance counters are unavailable: %s%s\n", counters ? "Some" : "All", strerror(error),
+               error == EACCES || error == EPERM ? " (see /proc/sys/kernel/perf_event_paranoid)" : "");
     }
 }
 
 int main(int argc, char* argv[]) {
-    if (argc < 2 || argc > 3) {
-        printf("Usage: %s <num_threads> [num_points]\n", argv[0]);
+    int use_hull = 0;
+    int kernel_kind = KERNEL_AUTO;
+    int pin = PIN_COMPACT;
+    const char* input = NULL;
+    int tile_override = -1;
+    int prune = 1;
+    double approx_eps = 0.0;
+    int top_k = 1;
+    int quantize = 0;
+    int perf = 0;
+    int deadline_ms = 0;
+    int progress_ms = 0;
+    int objective = MAXTRI_MAX_AREA;
+    int text_double = 0;
+    int procs = 0;
+    int pool_threads = 0;
+    int coreset_grid = 0;
+    const char* coordinator_port = NULL;
+    const char* worker_address = NULL;
+    const char* stream_path = NULL;
+    const char* batch_path = NULL;
+    const char* build_index_path = NULL;
+    const char* index_path = NULL;
+    const char* ranges = NULL;
+    static const struct option long_options[] = {
+        {"tile", required_argument, NULL, 'T'},
+        {"input", required_argument, NULL, 'i'},
+        {"hull", no_argument, NULL, 'H'},
+        {"kernel", required_argument, NULL, 'K'},
+        {"pin", required_argument, NULL, 'P'},
+        {"no-prune", no_argument, NULL, 'N'},
+        {"quantize", no_argument, NULL, 'Q'},
+        {"perf", no_argument, NULL, 'E'},
+        {"deadline", required_argument, NULL, 'D'},
+        {"progress", required_argument, NULL, 'R'},
+        {"objective", required_argument, NULL, 'O'},
+        {"double", no_argument, NULL, 'F'},
+        {"approx", required_argument, NULL, 'A'},
+        {"top", required_argument, NULL, 't'},
+        {"coordinator", required_argument, NULL, 'C'},
+        {"worker", required_argument, NULL, 'W'},
+        {"procs", required_argument, NULL, 'M'},
+        {"pool-threads", required_argument, NULL, 'L'},
+        {"coreset", required_argument, NULL, 'G'},
+        {"stream", required_argument, NULL, 'S'},
+        {"batch", required_argument, NULL, 'B'},
+        {"build-index", required_argument, NULL, 'I'},
+        {"index", required_argument, NULL, 'X'},
+        {"range", required_argument, NULL, 'U'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    char* endptr;
+    while ((opt = getopt_long(argc, argv, "HK:P:i:T:A:t:C:W:S:B:Q", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 'H':
+            use_hull = 1;
+            break;
+        case 'A':
+            approx_eps = strtod(optarg, &endptr);
+            if (*endptr != '\0' || !(approx_eps > 0.0 && approx_eps < 1.0)) {
+                printf("Approximation eps must be between 0 and 1\n");
+                return 1;
+            }
+            break;
+        case 't': {
+            long k_long = strtol(optarg, &endptr, 10);
+            if (*endptr != '\0' || k_long < 1 || k_long > 1000000) {
+                printf("Number of top triangles must be between 1 and 1000000\n");
+                return 1;
+            }
+            top_k = (int)k_long;
+            break;
+        }
+        case 'C':
+            coordinator_port = optarg;
+            break;
+        case 'W':
+            worker_address = optarg;
+            break;
+        case 'M': {
+            long procs_long = strtol(optarg, &endptr, 10);
+            if (*endptr != '\0' || procs_long < 1 || procs_long > 4096) {
+                printf("Number of processes must be between 1 and 4096\n");
+                return 1;
+            }
+            procs = (int)procs_long;
+            break;
+        }
+        case 'L': {
+            long pool_threads_long = strtol(optarg, &endptr, 10);
+            if (*endptr != '\0' || pool_threads_long < 1 || pool_threads_long > 4096) {
+                printf("Number of pool threads must be between 1 and 4096\n");
+                return 1;
+            }
+            pool_threads = (int)pool_threads_long;
+            break;
+        }
+        case 'G': {
+            long grid_long = strtol(optarg, &endptr, 10);
+            if (*endptr != '\0' || grid_long < 1 || grid_long > 256) {
+                printf("Coreset grid must be between 1 and 256\n");
+                return 1;
+            }
+            coreset_grid = (int)grid_long;
+            break;
+        }
+        case 'S':
+            stream_path = optarg;
+            break;
+        case 'B':
+            batch_path = optarg;
+            break;
+        case 'I':
+            build_index_path = optarg;
+            break;
+        case 'X':
+            index_path = optarg;
+            break;
+        case 'U':
+            ranges = optarg;
+            break;
+        case 'N':
+            prune = 0;
+            break;
+        case 'Q':
+            quantize = 1;
+            break;
+        case 'E':
+            perf = 1;
+            break;
+        case 'O':
+            objective = maxtri_objective_parse(optarg);
+            if (objective < 0) {
+                printf("Unknown objective: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'F':
+            text_double = 1;
+            break;
+        case 'D':
+        case 'R': {
+            long ms_long = strtol(optarg, &endptr, 10);
+            if (*endptr != '\0' || ms_long < 1 || ms_long > INT_MAX) {
+                printf("%s must be a positive number of milliseconds\n", opt == 'D' ? "Deadline" : "Progress interval");
+                return 1;
+            }
+            if (opt == 'D') {
+                deadline_ms = (int)ms_long;
+            } else {
+                progress_ms = (int)ms_long;
+            }
+            break;
+        }
+        case 'i':
+            input = optarg;
+            break;
+        case 'T':
+            tile_override = (int)strtol(optarg, &endptr, 10);
+            if (*endptr != '\0' || tile_override < 0) {
+                printf("Tile size must be a non-negative integer\n");
+                return 1;
+            }
+            break;
+        case 'K':
+            kernel_kind = kernel_parse(optarg);
+            if (kernel_kind < 0) {
+                printf("Unknown kernel: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'P':
+            pin = pool_parse_pin(optarg);
+            if (pin < 0) {
+                printf("Unknown pinning policy: %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    int args_count = argc - optind;
+    char** args_values = argv + optind;
+    if (args_count < 1 || args_count > 2) {
+        usage(argv[0]);
         return 1;
     }
-    if (num_points < 3) {
-        printf("Need at least 3 points to form a triangle\n");
+    int threads_amount;
+    if (strcmp(args_values[0], "auto") == 0) {
+        // По числу процессоров, на которых процессу разрешено работать
+        threads_amount = pool_cpu_count();
+    } else {
+        long threads_amount_long = strtol(args_values[0], &endptr, 10);
+        if (*endptr != '\0' || threads_amount_long < 1 || threads_amount_long > INT_MAX) {
+            printf("Number of threads must be a positive integer or auto\n");
+            return 1;
+        }
+        threads_amount = (int)threads_amount_long;
+    }
+    if (pool_threads != 0 && pool_threads < threads_amount) {
+        printf("--pool-threads must be at least num_threads\n");
         return 1;
     }
-    char* endptr;
-    long threads_amount_long = strtol(argv[1], &endptr, 10);
-    if (*endptr != '\0' || threads_amount_long < 1 || threads_amount_long > INT_MAX) {
-        printf("Number of threads must be a positive integer\n");
+
+    // Второй по площади треугольник уже может опираться на точку внутри оболочки
+    if (top_k > 1 && (use_hull || approx_eps > 0.0 || quantize)) {
+        printf("--top cannot be combined with --hull, --approx or --quantize\n");
+        return 1;
+    }
+    if ((coordinator_port != NULL || worker_address != NULL) && (top_k > 1 || approx_eps > 0.0)) {
+        printf("--top and --approx are not supported in distributed mode\n");
+        return 1;
+    }
+    if (stream_path != NULL && (top_k > 1 || approx_eps > 0.0 || coordinator_port != NULL || worker_address != NULL)) {
+        printf("--stream cannot be combined with --top, --approx or distributed mode\n");
+        return 1;
+    }
+    if ((deadline_ms > 0 || progress_ms > 0)
+        && (quantize || coordinator_port != NULL || worker_address != NULL || stream_path != NULL)) {
+        printf("--deadline and --progress cannot be combined with --quantize, --stream or distributed mode\n");
+        return 1;
+    }
+    if (batch_path != NULL && (top_k > 1 || perf || progress_ms > 0 || input != NULL || stream_path != NULL
+                               || coordinator_port != NULL || worker_address != NULL || args_count == 2)) {
+        printf("--batch cannot be combined with --top, --perf, --progress, --input, --stream, distributed mode or num_points\n");
+        return 1;
+    }
+    if (procs > 0 && (top_k > 1 || approx_eps > 0.0 || quantize || perf || deadline_ms > 0 || progress_ms > 0
+                      || coordinator_port != NULL || worker_address != NULL || stream_path != NULL || batch_path != NULL)) {
+        printf("--procs cannot be combined with --top, --approx, --quantize, --perf, --deadline, --progress, "
+               "--stream, --batch or distributed mode\n");
+        return 1;
+    }
+    if (coreset_grid > 0 && (input == NULL || use_hull || top_k > 1 || approx_eps > 0.0 || quantize || perf
+                             || deadline_ms > 0 || progress_ms > 0 || objective != MAXTRI_MAX_AREA || text_double
+                             || procs > 0 || coordinator_port != NULL || worker_address != NULL || stream_path != NULL
+                             || batch_path != NULL || args_count == 2)) {
+        printf("--coreset needs --input and cannot be combined with --hull, --top, --approx, --quantize, --perf, "
+               "--deadline, --progress, --objective, --double, --procs, --stream, --batch, distributed mode "
+               "or num_points\n");
+        return 1;
+    }
+    if ((build_index_path != NULL || index_path != NULL)
+        && (use_hull || top_k > 1 || perf || deadline_ms > 0 || progress_ms > 0 || objective != MAXTRI_MAX_AREA
+            || text_double || procs > 0 || coreset_grid > 0 || coordinator_port != NULL || worker_address != NULL
+            || stream_path != NULL || batch_path != NULL)) {
+        printf("--build-index and --index cannot be combined with --hull, --top, --perf, --deadline, --progress, "
+               "--objective, --double, --procs, --coreset, --stream, --batch or distributed mode\n");
+        return 1;
+    }
+    if (build_index_path != NULL && (index_path != NULL || ranges != NULL || args_count == 2)) {
+        printf("--build-index indexes the whole point set and cannot be combined with --index, --range or num_points\n");
+        return 1;
+    }
+    if (ranges != NULL && (index_path == NULL || args_count == 2)) {
+        printf("--range needs --index and cannot be combined with num_points\n");
+        return 1;
+    }
+    if (coordinator_port != NULL && worker_address != NULL) {
+        printf("--coordinator and --worker cannot be combined\n");
+        return 1;
+    }
+    if (kernel_get(kernel_kind) == NULL) {
+        printf("Kernel %s is not supported by this CPU\n", kernel_name(kernel_kind));
+        return 1;
+    }
+
+    // Параллельной версии нужен пул: его потоки создаются заранее и не входят в замер.
+    // Потоков в пуле может быть больше num_threads, но работают одновременно не больше num_threads
+    ThreadPool* pool = NULL;
+    if (pool_threads == 0) {
+        pool_threads = threads_amount;
+    }
+    if (pool_threads > 1) {
+        pool = pool_create(pool_threads, threads_amount, pin);
+        if (pool == NULL) {
+            printf("Failed to create threads\n");
+            return 1;
+        }
+        if (pool_workers(pool) < threads_amount) {
+            threads_amount = pool_workers(pool);
+        }
+    }
+
+    // Работник получает точки и настройки перебора от координатора
+    if (worker_address != NULL) {
+        maxtri_opts opts;
+        maxtri_opts_init(&opts, MAXTRI_THREADS);
+        opts.kernel = kernel_kind;
+        opts.pool = pool;
+        int status = dist_work(worker_address, &opts);
+        if (pool != NULL) {
+            pool_destroy(pool);
+        }
+        if (status != MAXTRI_OK) {
+            printf("Worker failed: %s\n", maxtri_strerror(status));
+            return 1;
+        }
+        return 0;
+    }
+
+    // Наборы пакета загружаются задачами пула по одному
+    if (batch_path != NULL) {
+        maxtri_opts opts;
+        maxtri_opts_init(&opts, use_hull ? MAXTRI_HULL : MAXTRI_THREADS);
+        opts.kernel = kernel_kind;
+        opts.tile = tile_override;
+        opts.prune = prune;
+        opts.approx_eps = approx_eps;
+        opts.quantize = quantize;
+        opts.deadline_ms = deadline_ms;
+        opts.objective = objective;
+        opts.pool = pool;
+        int failed = 0;
+        int status = batch_run(batch_path, &opts, text_double ? sizeof(double) : sizeof(float), &failed);
+        if (pool != NULL) {
+            pool_destroy(pool);
+        }
+        if (status != MAXTRI_OK) {
+            printf("Batch failed: %s\n", maxtri_strerror(status));
+            return 1;
+        }
+        // Как и у запросов по диапазонам: хотя бы один неудачный набор — ненулевой код возврата
+        return failed > 0 ? 1 : 0;
+    }
+
+    // Файл читается один раз порциями, в памяти остаются только крайние точки по направлениям
+    if (coreset_grid > 0) {
+        maxtri_opts opts;
+        maxtri_opts_init(&opts, threads_amount == 1 ? MAXTRI_SIMD : MAXTRI_THREADS);
+        opts.threads = threads_amount;
+        opts.kernel = kernel_kind;
+        opts.tile = tile_override;
+        opts.prune = prune;
+        opts.pool = pool;
+        struct timespec start, end;
+        CoresetResult result;
+        const char* error;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int status = coreset_run(input, coreset_grid, &opts, &result, &error);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        if (pool != NULL) {
+            pool_destroy(pool);
+        }
+        if (error != NULL) {
+            printf("Failed to load %s: %s\n", input, error);
+            return 1;
+        }
+        if (status != MAXTRI_OK) {
+            printf("Search failed: %s\n", maxtri_strerror(status));
+            return 1;
+        }
+        long long time_ms = (end.tv_sec - start.tv_sec) * 1000LL + (end.tv_nsec - start.tv_nsec) / 1000000LL;
+        printf("Coreset: %d of %lld points (grid %d, %d directions, %zu KB of state)\n", result.size,
+               result.points, result.grid, result.directions, result.memory / 1024);
+        printf("Coreset time with %d threads: %lld ms\n", threads_amount, time_ms);
+        printf("Max area: %.2f at points %lld, %lld, %lld\n", result.area, result.i, result.j, result.k);
+        if (result.exact) {
+            printf("Exact: all points fit into the coreset\n");
+        } else {
+            printf("Guaranteed ratio: %.4f (optimum is at most %.2f)\n", result.ratio, result.area + result.loss);
+        }
+        return 0;
+    }
+
+    // Без --input используются точки, собранные в программу из coordinates_data.c
+    PointSet set = {coordinates, num_points, NULL, 0, NULL, 3, sizeof(float), coordinates};
+    if (input != NULL) {
+        const char* error = points_load_as(input, pool, text_double ? sizeof(double) : sizeof(float), &set);
+        if (error != NULL) {
+            printf("Failed to load %s: %s\n", input, error);
+            return 1;
+        }
+    }
+    // Всё, кроме наибольшей площади 3D float32, ищет перебор, собранный под сочетание (spec.c)
+    if ((objective != MAXTRI_MAX_AREA || set.xyz == NULL)
+        && (use_hull || approx_eps > 0.0 || top_k > 1 || quantize || perf || deadline_ms > 0 || progress_ms > 0
+            || coordinator_port != NULL || stream_path != NULL || procs > 0
+            || build_index_path != NULL || index_path != NULL)) {
+        printf("--hull, --approx, --top, --quantize, --perf, --deadline, --progress, --stream, --procs, --build-index, "
+               "--index and distributed mode need 3D float32 points and the area objective\n");
+        return 1;
+    }
+    // Поток точек начинается с --input, а без него — с пустого набора
+    if (stream_path != NULL) {
+        int initial = input != NULL ? set.n : 0;
+        if (args_count == 2) {
+            long n_long = strtol(args_values[1], &endptr, 10);
+            if (*endptr != '\0' || n_long < 0 || n_long > initial) {
+                printf("Number of points must be between 0 and %d\n", initial);
+                return 1;
+            }
+            initial = (int)n_long;
+        }
+        maxtri_opts opts;
+        maxtri_opts_init(&opts, MAXTRI_HULL);
+        opts.kernel = kernel_kind;
+        opts.tile = tile_override;
+        opts.prune = prune;
+        opts.pool = pool;
+        int status = stream_run(stream_path, set.xyz, initial, &opts);
+        if (pool != NULL) {
+            pool_destroy(pool);
+        }
+        points_unload(&set);
+        if (status != MAXTRI_OK) {
+            printf("Stream failed: %s\n", maxtri_strerror(status));
+            return 1;
+        }
+        return 0;
+    }
+    if (set.n < 3) {
+        printf("Need at least 3 points to form a triangle\n");
         return 1;
     }
-    int threads_amount = (int)threads_amount_long;
 
     int n;
-    if (argc == 3) {
-        long n_long = strtol(argv[2], &endptr, 10);
-        if (*endptr != '\0' || n_long < 3 || n_long > num_points) {
-            printf("Number of points must be between 3 and %d\n", num_points);
+    if (args_count == 2) {
+        long n_long = strtol(args_values[1], &endptr, 10);
+        if (*endptr != '\0' || n_long < 3 || n_long > set.n) {
+            printf("Number of points must be between 3 and %d\n", set.n);
             return 1;
         }
         n = (int)n_long;
     } else {
-        n = num_points;
+        n = set.n;
     }
 
-    struct timespec start, end;
-    long long time_ms;
-
-    if (threads_amount == 1) {
-        // Последовательная версия
+    // Индекс строится один раз для всего набора, а запросы по диапазонам идут к сохранённому файлу
+    if (build_index_path != NULL) {
+        struct timespec start, end;
+        long long ids = 0;
         clock_gettime(CLOCK_MONOTONIC, &start);
-        sequential_find(n);
+        const char* error = hull_index_build(set.xyz, set.n, pool, build_index_path, &ids);
         clock_gettime(CLOCK_MONOTONIC, &end);
-        time_ms = (end.tv_sec - start.tv_sec) * 1000LL + (end.tv_nsec - start.tv_nsec) / 1000000LL;
-        printf("Sequential time: %lld ms\n", time_ms);
-    } else {
-        // Параллельная версия
+        if (pool != NULL) {
+            pool_destroy(pool);
+        }
+        int leaves = (set.n + HULL_INDEX_LEAF - 1) / HULL_INDEX_LEAF;
+        points_unload(&set);
+        if (error != NULL) {
+            printf("Failed to build index %s: %s\n", build_index_path, error);
+            return 1;
+        }
+        long long time_ms = (end.tv_sec - start.tv_sec) * 1000LL + (end.tv_nsec - start.tv_nsec) / 1000000LL;
+        printf("Index: %d leaves of %d points, %lld hull vertices stored\n", leaves, HULL_INDEX_LEAF, ids);
+        printf("Index time with %d threads: %lld ms\n", threads_amount, time_ms);
+        return 0;
+    }
+    // Без --range — один запрос по первым n точкам
+    if (index_path != NULL) {
+        HullIndex index;
+        const char* error = hull_index_open(&index, index_path, set.xyz, set.n);
+        if (error != NULL) {
+            printf("Failed to open index %s: %s\n", index_path, error);
+            return 1;
+        }
+        maxtri_opts opts;
+        maxtri_opts_init(&opts, threads_amount == 1 ? MAXTRI_SIMD : MAXTRI_THREADS);
+        opts.threads = threads_amount;
+        opts.kernel = kernel_kind;
+        opts.tile = tile_override;
+        opts.prune = prune;
+        opts.approx_eps = approx_eps;
+        opts.quantize = quantize;
+        opts.pool = pool;
+        struct timespec start, end;
         clock_gettime(CLOCK_MONOTONIC, &start);
-        pthread_t* threads = malloc(threads_amount * sizeof(pthread_t));
-        ThreadArgs* args = malloc(threads_amount * sizeof(ThreadArgs));
-        for (int i = 0; i < threads_amount; ++i) {
-            args[i].start = i;
-            args[i].points_count = n;
-            args[i].threads_count = threads_amount;
-            pthread_create(&threads[i], NULL, FindTriangle, &args[i]);
-        }
-        // Собираем итоговые результаты
-        for (int i = 0; i < threads_amount; ++i) {
-            Result* res;
-            pthread_join(threads[i], (void**)&res);
-            if (res->area > max_area) {
-                max_area = res->area;
-                max_i = res->i;
-                max_j = res->j;
-                max_k = res->k;
+        int queries = 0;
+        int failed = 0;
+        int l, r;
+        const char* rest;
+        if (ranges == NULL) {
+            failed += run_range(&index, set.xyz, 0, n, &opts) != 0;
+            ++queries;
+        } else if (strcmp(ranges, "-") == 0) {
+            // По запросу в строке, ответ выводится сразу
+            char line[256];
+            while (fgets(line, sizeof(line), stdin) != NULL) {
+                const char* p = line;
+                while (*p == ' ' || *p == '\t') ++p;
+                if (*p == '\n' || *p == '\0' || *p == '#') {
+                    continue;
+                }
+                ++queries;
+                if (parse_range(p, &l, &r, &rest) != 0 || strspn(rest, " \t\r\n") != strlen(rest)) {
+                    printf("Invalid range: %s", line);
+                    ++failed;
+                } else {
+                    failed += run_range(&index, set.xyz, l, r, &opts) != 0;
+                }
+                fflush(stdout);
+            }
+        } else {
+            for (const char* p = ranges; ; p = rest + 1) {
+                if (parse_range(p, &l, &r, &rest) != 0 || (*rest != ',' && *rest != '\0')) {
+                    printf("Invalid range list: %s\n", ranges);
+                    ++failed;
+                    break;
+                }
+                failed += run_range(&index, set.xyz, l, r, &opts) != 0;
+                ++queries;
+                if (*rest == '\0') {
+                    break;
+                }
             }
-            free(res);
         }
         clock_gettime(CLOCK_MONOTONIC, &end);
-        time_ms = (end.tv_sec - start.tv_sec) * 1000LL + (end.tv_nsec - start.tv_nsec) / 1000000LL;
+        hull_index_close(&index);
+        if (pool != NULL) {
+            pool_destroy(pool);
+        }
+        points_unload(&set);
+        long long time_ms = (end.tv_sec - start.tv_sec) * 1000LL + (end.tv_nsec - start.tv_nsec) / 1000000LL;
+        printf("Queries: %d (%d failed) in %lld ms\n", queries, failed, time_ms);
+        return failed > 0 ? 1 : 0;
+    }
+
+    // Один поток — векторное ядро в вызывающем потоке, иначе перебор на пуле
+    maxtri_opts opts;
+    maxtri_opts_init(&opts, use_hull ? MAXTRI_HULL : (threads_amount == 1 ? MAXTRI_SIMD : MAXTRI_THREADS));
+    opts.threads = threads_amount;
+    opts.kernel = kernel_kind;
+    opts.tile = tile_override;
+    opts.prune = prune;
+    opts.approx_eps = approx_eps;
+    opts.top_k = top_k;
+    opts.quantize = quantize;
+    opts.perf = perf;
+    opts.objective = objective;
+    opts.deadline_ms = deadline_ms;
+    if (progress_ms > 0) {
+        opts.progress = print_progress;
+        opts.progress_ms = progress_ms;
+    }
+    opts.pool = pool;
+
+    struct timespec start, end;
+    maxtri_result result;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int workers = 0;
+    int failed = 0;
+    int status = coordinator_port != NULL
+        ? dist_coordinate(coordinator_port, set.xyz, n, &opts, &result, &workers)
+        : procs > 0 ? procs_find(set.xyz, n, procs, &opts, &result, &failed)
+        : maxtri_find_points(set.data, n, set.dim, set.scalar_size, &opts, &result);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (status != MAXTRI_OK) {
+        printf("Search failed: %s\n", maxtri_strerror(status));
+        return 1;
+    }
+    long long time_ms = (end.tv_sec - start.tv_sec) * 1000LL + (end.tv_nsec - start.tv_nsec) / 1000000LL;
+    if (result.hull_count > 0) {
+        printf("Hull vertices: %d of %d points\n", result.hull_count, n);
+    }
+    if (result.approx_grid > 0) {
+        printf("Approx candidates: %d (grid %d)\n", result.candidates, result.approx_grid);
+    }
+    if (result.quant_pairs > 0) {
+        printf("Quantized prefilter: %lld of %lld pairs kept\n", result.quant_kept, result.quant_pairs);
+    }
+    if (coordinator_port != NULL) {
+        printf("Distributed time with %d workers: %lld ms\n", workers, time_ms);
+    } else if (procs > 0) {
+        printf("Multi-process time with %d processes: %lld ms\n", procs, time_ms);
+        if (failed > 0) {
+            printf("Failed processes: %d, their chunks were searched again\n", failed);
+        }
+    } else if (threads_amount == 1) {
+        printf("Sequential time: %lld ms\n", time_ms);
+    } else {
         printf("Parallel time with %d threads: %lld ms\n", threads_amount, time_ms);
-        free(threads);
-        free(args);
     }
+    if (result.perf_count > 0) {
+        print_perf(&result);
+    }
+    if (pool != NULL) {
+        pool_destroy(pool);
+    }
+    points_unload(&set);
 
-    printf("Max area: %.2f at points %d, %d, %d\n", max_area, max_i, max_j, max_k);
+    const maxtri_triangle* best = &result.best;
+    static const char* const labels[] = {"Max area", "Max perimeter", "Min area"};
+    printf("%s: %.2f at points %d, %d, %d\n", labels[objective], best->area, best->i, best->j, best->k);
+    if (deadline_ms > 0) {
+        printf("Coverage: %.1f%% of triples%s\n", result.coverage * 100.0,
+               result.coverage < 1.0 ? " (stopped at deadline, best found so far)" : "");
+    }
+    // Без треугольника гарантировать нечего
+    if (approx_eps > 0.0 && best->i >= 0) {
+        if (result.ratio > 0.0) {
+            printf("Guaranteed ratio: %.4f (eps %g)\n", result.ratio, approx_eps);
+        } else {
+            printf("Guaranteed ratio: none, search stopped at deadline (eps %g)\n", approx_eps);
+        }
+    }
+    if (top_k > 1) {
+        printf("Top %d triangles:\n", result.top_count);
+        for (int t = 0; t < result.top_count; ++t) {
+            const maxtri_triangle* tr = &result.top[t];
+            printf("%d. %.2f at points %d, %d, %d\n", t + 1, tr->area, tr->i, tr->j, tr->k);
+        }
+    }
+    maxtri_result_free(&result);
     return 0;
 }
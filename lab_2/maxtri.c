@@ -0,0 +1,333 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "maxtri.h"
+#include "engine.h"
+#include "hull.h"
+#include "approx.h"
+#include "quant.h"
+#include "spec.h"
+
+void maxtri_opts_init(maxtri_opts* opts, maxtri_backend backend) {
+    memset(opts, 0, sizeof(maxtri_opts));
+    opts->backend = backend;
+    opts->kernel = backend == MAXTRI_SEQUENTIAL ? KERNEL_SCALAR : KERNEL_AUTO;
+    opts->pin = PIN_COMPACT;
+    opts->tile = -1;
+    opts->prune = 1;
+    opts->top_k = 1;
+}
+
+void maxtri_result_free(maxtri_result* result) {
+    free(result->top);
+    result->top = NULL;
+    result->top_count = 0;
+    free(result->perf);
+    result->perf = NULL;
+    result->perf_count = 0;
+}
+
+const char* maxtri_strerror(int status) {
+    switch (status) {
+    case MAXTRI_OK: return "success";
+    case MAXTRI_EINVAL: return "invalid arguments";
+    case MAXTRI_ENOMEM: return "out of memory";
+    case MAXTRI_EKERNEL: return "kernel is not supported by this CPU";
+    case MAXTRI_ETHREAD: return "failed to create threads";
+    case MAXTRI_ENET: return "network error";
+    case MAXTRI_EPROC: return "failed to set up shared memory";
+    default: return "unknown error";
+    }
+}
+
+static maxtri_triangle make_triangle(float cross2, int i, int j, int k, const int* ids) {
+    maxtri_triangle t = {0.0, -1, -1, -1};
+    if (i >= 0) {
+        t.area = 0.5 * sqrt(cross2);
+        t.i = ids ? ids[i] : i;
+        t.j = ids ? ids[j] : j;
+        t.k = ids ? ids[k] : k;
+    }
+    return t;
+}
+
+static long long elapsed_ns(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000000000LL + (now.tv_nsec - start->tv_nsec);
+}
+
+typedef struct {
+    const maxtri_opts* opts;
+    struct timespec start;
+} ProgressContext;
+
+static void report_progress(void* arg, float bound, double coverage) {
+    const ProgressContext* context = (const ProgressContext*)arg;
+    maxtri_progress progress = {elapsed_ns(&context->start) / 1e6, coverage, 0.5 * sqrt(bound)};
+    context->opts->progress(&progress, context->opts->progress_arg);
+}
+
+// Однопоточные варианты не трогают пул, многопоточным без готового пула он создаётся здесь
+static int acquire_pool(const maxtri_opts* opts, ThreadPool** pool, ThreadPool** own_pool, int* threads) {
+    if (opts->backend == MAXTRI_THREADS || opts->backend == MAXTRI_HULL) {
+        *threads = opts->threads > 0 ? opts->threads : (opts->pool ? pool_workers(opts->pool) : pool_cpu_count());
+        if (*threads > 1) {
+            *pool = opts->pool;
+            if (*pool == NULL) {
+                *pool = *own_pool = pool_create(*threads, *threads, opts->pin);
+                if (*pool == NULL) {
+                    return -1;
+                }
+                *threads = pool_workers(*pool);
+            }
+        }
+    }
+    return 0;
+}
+
+int maxtri_find(const float* xyz_flat, size_t count, const maxtri_opts* opts_in, maxtri_result* out) {
+    maxtri_opts defaults;
+    if (opts_in == NULL) {
+        maxtri_opts_init(&defaults, MAXTRI_THREADS);
+        opts_in = &defaults;
+    }
+    const maxtri_opts* opts = opts_in;
+    if (opts->objective != MAXTRI_MAX_AREA) {
+        return maxtri_find_points(xyz_flat, count, 3, sizeof(float), opts, out);
+    }
+    ProgressContext progress = {opts, {0, 0}};
+    clock_gettime(CLOCK_MONOTONIC, &progress.start);
+    memset(out, 0, sizeof(maxtri_result));
+    out->best = make_triangle(0.0f, -1, -1, -1, NULL);
+    out->ratio = 1.0;
+    out->coverage = 1.0;
+
+    int use_hull = opts->backend == MAXTRI_HULL || opts->approx_eps > 0.0;
+    // Второй по площади треугольник уже может опираться на точку внутри оболочки
+    if (xyz_flat == NULL || count < 3 || count > INT_MAX || opts->top_k < 1
+        || !(opts->approx_eps >= 0.0 && opts->approx_eps < 1.0) || (opts->top_k > 1 && (use_hull || opts->quantize))
+        || opts->deadline_ms < 0 || opts->progress_ms < 0 || (opts->quantize && (opts->deadline_ms > 0 || opts->progress))) {
+        return MAXTRI_EINVAL;
+    }
+    const float (*xyz)[3] = (const float (*)[3])xyz_flat;
+    int n = (int)count;
+
+    EngineConfig config;
+    config.row_kernel = kernel_get(opts->kernel);
+    config.norm_kernel = kernel_norms_get(opts->kernel);
+    if (config.row_kernel == NULL || config.norm_kernel == NULL) {
+        return MAXTRI_EKERNEL;
+    }
+    kernel_tile_sizes(&config.tile_j, &config.tile_k);
+    if (opts->tile >= 0) {
+        config.tile_k = opts->tile;
+    }
+    config.prune = opts->prune;
+    config.top_k = opts->top_k;
+
+    ThreadPool* pool = NULL;
+    ThreadPool* own_pool = NULL;
+    int threads = 1;
+    if (acquire_pool(opts, &pool, &own_pool, &threads) != 0) {
+        return MAXTRI_ETHREAD;
+    }
+
+    int status = MAXTRI_OK;
+    int* hull_ids = NULL;
+    int* ids = NULL;
+    Approx approx = {0};
+    approx.eps = opts->approx_eps;
+    if (use_hull) {
+        hull_ids = malloc(n * sizeof(int));
+        if (hull_ids == NULL) {
+            status = MAXTRI_ENOMEM;
+            goto done;
+        }
+        n = hull_vertices_parallel(xyz, n, pool, hull_ids);
+        out->hull_count = n;
+        ids = hull_ids;
+    }
+    // При приближённом поиске из вершин оболочки остаются только крайние по направлениям сетки
+    if (opts->approx_eps > 0.0) {
+        ids = malloc(n * sizeof(int));
+        if (ids == NULL) {
+            status = MAXTRI_ENOMEM;
+            goto done;
+        }
+        n = approx_candidates(xyz, hull_ids, out->hull_count, pool, &approx, ids);
+        out->approx_grid = approx.grid;
+    }
+    out->candidates = n;
+
+    Engine engine;
+    Scan scan;
+    if (engine_init(&engine, xyz, ids, n, &config) != 0) {
+        status = MAXTRI_ENOMEM;
+        goto done;
+    }
+    if (scan_init(&scan, &engine) != 0) {
+        engine_free(&engine);
+        status = MAXTRI_ENOMEM;
+        goto done;
+    }
+    // Счётчики открываются в каждой задаче перебора, то есть в потоке, который её выполняет
+    if (opts->perf) {
+        out->perf = malloc(threads * sizeof(PerfSample));
+        if (out->perf == NULL) {
+            scan_free(&scan);
+            engine_free(&engine);
+            status = MAXTRI_ENOMEM;
+            goto done;
+        }
+        out->perf_count = threads;
+        for (int t = 0; t < threads; ++t) {
+            perf_sample_init(&out->perf[t]);
+        }
+        engine.perf = out->perf;
+    }
+    // Со сроком сначала перебираются строки самых дальних от центра точек, чтобы ранний ответ уже был хорошим
+    if (opts->deadline_ms > 0) {
+        engine.far_first = 1;
+        engine.deadline_ns = (progress.start.tv_sec + opts->deadline_ms / 1000) * 1000000000LL
+                           + progress.start.tv_nsec + (opts->deadline_ms % 1000) * 1000000LL;
+    }
+    if (opts->progress != NULL) {
+        engine.progress = report_progress;
+        engine.progress_arg = &progress;
+        engine.progress_ns = (opts->progress_ms > 0 ? opts->progress_ms : 100) * 1000000LL;
+    }
+    struct timespec run_start, run_end;
+    clock_gettime(CLOCK_MONOTONIC, &run_start);
+    QuantStats quant_stats = {0, 0};
+    int run_status = opts->quantize
+        ? quant_run(&engine, quant_kernel_get(opts->kernel), pool, threads, &scan, &quant_stats)
+        : engine_run(&engine, pool, threads, &scan);
+    clock_gettime(CLOCK_MONOTONIC, &run_end);
+    out->perf_wall_ns = (run_end.tv_sec - run_start.tv_sec) * 1000000000LL + (run_end.tv_nsec - run_start.tv_nsec);
+    out->triples = scan.triples;
+    if (!opts->quantize) {
+        out->coverage = engine_coverage(&engine);
+    }
+    // Остановленный перебор мог не дойти до пары быстрого треугольника, а он уже лучше многих
+    if (out->coverage < 1.0 && config.top_k == 1) {
+        Scan seed = {0};
+        int tri[3];
+        seed.best = bounds_seed(&engine.points, config.row_kernel, tri);
+        seed.i = tri[0];
+        seed.j = tri[1];
+        seed.k = tri[2];
+        scan_merge(&scan, &seed);
+    }
+    out->quant_pairs = quant_stats.pairs;
+    out->quant_kept = quant_stats.kept;
+    if (run_status != 0) {
+        status = MAXTRI_ENOMEM;
+    } else if (config.top_k > 1) {
+        topk_sort(&scan.top);
+        out->top = malloc((scan.top.count > 0 ? scan.top.count : 1) * sizeof(maxtri_triangle));
+        if (out->top == NULL) {
+            status = MAXTRI_ENOMEM;
+        } else {
+            out->top_count = scan.top.count;
+            for (int t = 0; t < scan.top.count; ++t) {
+                const Triangle* tr = &scan.top.items[t];
+                out->top[t] = make_triangle(tr->cross2, tr->i, tr->j, tr->k, ids);
+            }
+            if (out->top_count > 0) {
+                out->best = out->top[0];
+            }
+        }
+    } else {
+        out->best = make_triangle(scan.best, scan.i, scan.j, scan.k, ids);
+    }
+    scan_free(&scan);
+    engine_free(&engine);
+
+    // Локальный поиск от найденного треугольника и итоговая гарантия приближённого поиска
+    if (status == MAXTRI_OK && opts->approx_eps > 0.0) {
+        maxtri_triangle* best = &out->best;
+        best->area = approx_refine(xyz, hull_ids, out->hull_count, &approx, &best->i, &best->j, &best->k);
+        out->ratio = out->coverage < 1.0 || best->i < 0 ? 0.0 : approx_ratio(&approx, best->area);
+    }
+
+done:
+    if (ids != hull_ids) {
+        free(ids);
+    }
+    free(hull_ids);
+    if (own_pool != NULL) {
+        pool_destroy(own_pool);
+    }
+    if (status != MAXTRI_OK) {
+        maxtri_result_free(out);
+    }
+    return status;
+}
+
+// nan и inf в координатах: перебор spec.c собран в предположении конечных значений
+static int points_finite(const void* data, size_t count, int dim, int scalar_size) {
+    size_t values = count * dim;
+    for (size_t v = 0; v < values; ++v) {
+        double value = scalar_size == sizeof(float) ? ((const float*)data)[v] : ((const double*)data)[v];
+        if (!isfinite(value)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int maxtri_find_points(const void* data, size_t count, int dim, int scalar_size, const maxtri_opts* opts_in,
+                       maxtri_result* out) {
+    maxtri_opts defaults;
+    if (opts_in == NULL) {
+        maxtri_opts_init(&defaults, MAXTRI_THREADS);
+        opts_in = &defaults;
+    }
+    const maxtri_opts* opts = opts_in;
+    if (dim == 3 && scalar_size == sizeof(float) && opts->objective == MAXTRI_MAX_AREA) {
+        return maxtri_find((const float*)data, count, opts, out);
+    }
+    memset(out, 0, sizeof(maxtri_result));
+    out->best = make_triangle(0.0f, -1, -1, -1, NULL);
+    out->ratio = 1.0;
+    out->coverage = 1.0;
+    if (data == NULL || count < 3 || count > INT_MAX || (dim != 2 && dim != 3)
+        || (scalar_size != sizeof(float) && scalar_size != sizeof(double))
+        || opts->objective < MAXTRI_MAX_AREA || opts->objective > MAXTRI_MIN_AREA
+        || opts->backend == MAXTRI_HULL || opts->approx_eps != 0.0 || opts->top_k != 1 || opts->quantize
+        || opts->perf || opts->deadline_ms != 0 || opts->progress != NULL
+        || !points_finite(data, count, dim, scalar_size)) {
+        return MAXTRI_EINVAL;
+    }
+    ThreadPool* pool = NULL;
+    ThreadPool* own_pool = NULL;
+    int threads = 1;
+    if (acquire_pool(opts, &pool, &own_pool, &threads) != 0) {
+        return MAXTRI_ETHREAD;
+    }
+    int n = (int)count;
+    SpecResult found;
+    int status = spec_find(data, n, dim, scalar_size, opts->objective, pool, threads, &found) == 0
+        ? MAXTRI_OK : MAXTRI_ENOMEM;
+    if (status == MAXTRI_OK) {
+        out->best = (maxtri_triangle){found.value, found.i, found.j, found.k};
+        out->candidates = n;
+        out->triples = (long long)n * (n - 1) * (n - 2) / 6;
+    }
+    if (own_pool != NULL) {
+        pool_destroy(own_pool);
+    }
+    return status;
+}
+
+int maxtri_objective_parse(const char* name) {
+    if (strcmp(name, "area") == 0) return MAXTRI_MAX_AREA;
+    if (strcmp(name, "perimeter") == 0) return MAXTRI_MAX_PERIMETER;
+    if (strcmp(name, "min-area") == 0) return MAXTRI_MIN_AREA;
+    return -1;
+}
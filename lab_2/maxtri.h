@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stddef.h>
+#include "pool.h"
+#include "perf.h"
+
+// libmaxtri: поиск треугольника максимальной площади среди точек в 3D.
+// Вызовы не используют глобального состояния, поэтому maxtri_find можно вызывать
+// из нескольких потоков одновременно, в том числе с общим пулом.
+
+typedef enum {
+    MAXTRI_SEQUENTIAL,  // один поток, скалярное ядро
+    MAXTRI_SIMD,        // один поток, векторное ядро
+    MAXTRI_THREADS,     // пул потоков, векторное ядро
+    MAXTRI_HULL         // перебор только по вершинам выпуклой оболочки на пуле потоков
+} maxtri_backend;
+
+typedef enum {
+    MAXTRI_OK = 0,
+    MAXTRI_EINVAL = -1,     // неверные параметры
+    MAXTRI_ENOMEM = -2,     // не хватило памяти
+    MAXTRI_EKERNEL = -3,    // процессор не поддерживает выбранное ядро
+    MAXTRI_ETHREAD = -4,    // не удалось создать потоки
+    MAXTRI_ENET = -5,       // ошибка сети при распределённом переборе
+    MAXTRI_EPROC = -6       // не удалось создать общую память для процессов-работников
+} maxtri_status;
+
+typedef enum {
+    MAXTRI_MAX_AREA,        // треугольник наибольшей площади
+    MAXTRI_MAX_PERIMETER,   // треугольник наибольшего периметра
+    MAXTRI_MIN_AREA         // треугольник наименьшей площади среди невырожденных
+} maxtri_objective;
+
+// Снимок хода перебора
+typedef struct {
+    double elapsed_ms;  // от начала maxtri_find
+    double coverage;    // доля пройденных троек
+    double area;        // лучшая площадь на момент снимка (при top_k > 1 — K-я)
+} maxtri_progress;
+
+typedef void (*maxtri_progress_fn)(const maxtri_progress* progress, void* arg);
+
+typedef struct {
+    maxtri_backend backend;
+    int threads;        // потоков для MAXTRI_THREADS и MAXTRI_HULL; 0 — по числу процессоров или потоков pool
+    int kernel;         // KernelKind из kernel.h
+    int pin;            // PinPolicy для пула, создаваемого на время вызова
+    int tile;           // третьих вершин в блоке обхода; -1 — по размеру кэша, 0 — без блоков
+    int prune;          // отсекать перебор по оценкам сверху
+    double approx_eps;  // > 0 — приближённый поиск с долей не меньше 1 - approx_eps
+    int top_k;          // сколько лучших треугольников вернуть в top
+    int quantize;       // сначала отбирать пары по координатам в int16 (только при top_k == 1)
+    int perf;           // снимать счётчики perf_event_open в каждом потоке перебора
+    int objective;      // maxtri_objective; всё, кроме MAXTRI_MAX_AREA, ищется только maxtri_find_points
+    // > 0 — вернуть лучшее найденное через deadline_ms от начала вызова. Первыми перебираются
+    // пары с самыми дальними от центра точками, чтобы ранний ответ уже был хорошим; не сочетается с quantize.
+    int deadline_ms;
+    maxtri_progress_fn progress;    // снимки хода перебора не чаще раза в progress_ms (NULL — без снимков)
+    void* progress_arg;
+    int progress_ms;
+    ThreadPool* pool;   // готовый пул; NULL — пул создаётся на время вызова
+} maxtri_opts;
+
+typedef struct {
+    double area;        // для MAXTRI_MAX_PERIMETER — периметр
+    int i, j, k;        // номера точек по возрастанию; -1 — треугольник не найден
+} maxtri_triangle;
+
+typedef struct {
+    maxtri_triangle best;
+    maxtri_triangle* top;   // при top_k > 1: top_count лучших по убыванию площади
+    int top_count;
+    int hull_count;         // вершин оболочки; 0 — оболочка не строилась
+    int candidates;         // точек, среди которых шёл перебор
+    int approx_grid;        // сетка направлений приближённого поиска; 0 — ответ точный
+    double ratio;           // гарантированная доля площади от максимальной; 0 — гарантии нет (перебор не закончен)
+    long long quant_pairs;  // при quantize: всех пар (i, j) и пар, дошедших до точного перебора
+    long long quant_kept;
+    long long triples;      // троек, посчитанных ядрами перебора
+    PerfSample* perf;       // при perf: perf_count задач перебора
+    int perf_count;
+    long long perf_wall_ns; // время перебора целиком; простой задачи — это время минус её busy_ns
+    double coverage;        // доля пройденных троек; меньше 1, если перебор остановлен по deadline_ms
+} maxtri_result;
+
+// Значения по умолчанию для backend: все ядра, кроме MAXTRI_SEQUENTIAL, — самое широкое
+// из поддерживаемых, отсечение включено, блоки по размеру кэша
+void maxtri_opts_init(maxtri_opts* opts, maxtri_backend backend);
+
+// Ищет треугольник максимальной площади среди n точек xyz[3 * p .. 3 * p + 2].
+// opts == NULL — значения по умолчанию для MAXTRI_THREADS. Возвращает MAXTRI_OK или код ошибки;
+// после успешного вызова out освобождается через maxtri_result_free.
+int maxtri_find(const float* xyz, size_t n, const maxtri_opts* opts, maxtri_result* out);
+
+// Ищет треугольник для opts->objective среди n точек размерности dim (2 или 3), координаты
+// которых идут подряд в data как float (scalar_size 4) или double (8). 3D float32 с наибольшей
+// площадью ищется как в maxtri_find, а для остальных сочетаний есть свой перебор, собранный
+// под размерность, тип и цель (spec.c). У него нет оболочки, отсечения и приближения, поэтому
+// MAXTRI_HULL, approx_eps, top_k > 1, quantize, perf, срок и снимки для них не поддерживаются.
+int maxtri_find_points(const void* data, size_t n, int dim, int scalar_size, const maxtri_opts* opts,
+                       maxtri_result* out);
+
+void maxtri_result_free(maxtri_result* result);
+
+// Разбор имени цели ("area", "perimeter", "min-area"), -1 — неизвестное имя
+int maxtri_objective_parse(const char* name);
+
+const char* maxtri_strerror(int status);
@@ -0,0 +1,113 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "perf.h"
+
+static const char* const event_names[PERF_EVENTS] = {
+    "cycles", "instructions", "L1D misses", "LLC misses", "branch misses"
+};
+
+static void event_attr(PerfEvent event, struct perf_event_attr* attr) {
+    memset(attr, 0, sizeof(*attr));
+    attr->size = sizeof(*attr);
+    attr->disabled = 1;
+    // Только пространство пользователя: так счётчики доступны и при perf_event_paranoid = 2
+    attr->exclude_kernel = 1;
+    attr->exclude_hv = 1;
+    // Событий больше, чем регистров у некоторых процессоров; ядро делит время между ними,
+    // а значение масштабируется по доле времени, когда счётчик работал
+    attr->read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    switch (event) {
+    case PERF_CYCLES:
+        attr->type = PERF_TYPE_HARDWARE;
+        attr->config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case PERF_INSTRUCTIONS:
+        attr->type = PERF_TYPE_HARDWARE;
+        attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case PERF_L1D_MISSES:
+        attr->type = PERF_TYPE_HW_CACHE;
+        attr->config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                     | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    case PERF_LLC_MISSES:
+        attr->type = PERF_TYPE_HW_CACHE;
+        attr->config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                     | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    case PERF_BRANCH_MISSES:
+    default:
+        attr->type = PERF_TYPE_HARDWARE;
+        attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    }
+}
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void perf_sample_init(PerfSample* sample) {
+    memset(sample, 0, sizeof(PerfSample));
+    for (int e = 0; e < PERF_EVENTS; ++e) {
+        sample->counts[e] = -1;
+    }
+}
+
+void perf_start(PerfCounters* counters) {
+    for (int e = 0; e < PERF_EVENTS; ++e) {
+        struct perf_event_attr attr;
+        event_attr((PerfEvent)e, &attr);
+        // pid = 0, cpu = -1: вызывающий поток на любом процессоре
+        counters->fds[e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        if (counters->fds[e] < 0) {
+            counters->fds[e] = -errno;
+        }
+    }
+    for (int e = 0; e < PERF_EVENTS; ++e) {
+        if (counters->fds[e] >= 0) {
+            ioctl(counters->fds[e], PERF_EVENT_IOC_RESET, 0);
+            ioctl(counters->fds[e], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+    counters->start_ns = now_ns();
+}
+
+void perf_stop(PerfCounters* counters, PerfSample* sample) {
+    long long elapsed = now_ns() - counters->start_ns;
+    for (int e = 0; e < PERF_EVENTS; ++e) {
+        if (counters->fds[e] >= 0) {
+            ioctl(counters->fds[e], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    sample->busy_ns += elapsed;
+    for (int e = 0; e < PERF_EVENTS; ++e) {
+        int fd = counters->fds[e];
+        if (fd < 0) {
+            if (sample->error == 0) sample->error = -fd;
+            continue;
+        }
+        uint64_t data[3];   // значение, время включения, время работы
+        if (read(fd, data, sizeof(data)) == (ssize_t)sizeof(data)) {
+            long long value = data[2] > 0 ? (long long)((double)data[0] * data[1] / data[2]) : 0;
+            sample->counts[e] = (sample->counts[e] < 0 ? 0 : sample->counts[e]) + value;
+        } else if (sample->error == 0) {
+            sample->error = errno;
+        }
+        close(fd);
+    }
+}
+
+const char* perf_event_name(PerfEvent event) {
+    return event >= 0 && event < PERF_EVENTS ? event_names[event] : "unknown";
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+// Аппаратные счётчики одного потока через perf_event_open. Каждый счётчик открывается отдельно,
+// поэтому неподдерживаемое событие или запрет ядра отключают только его, а время работы
+// потока считается всегда.
+
+typedef enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_EVENTS
+} PerfEvent;
+
+// Итог потока; несколько замеров одного потока складываются
+typedef struct {
+    long long counts[PERF_EVENTS];  // -1 — счётчик недоступен
+    int error;                      // errno первого неудачного открытия, 0 — все счётчики открылись
+    long long busy_ns;              // время от perf_start до perf_stop
+    long long triples;              // троек, посчитанных ядром
+} PerfSample;
+
+typedef struct {
+    int fds[PERF_EVENTS];
+    long long start_ns;
+} PerfCounters;
+
+// Все счётчики недоступны, время и тройки — нули
+void perf_sample_init(PerfSample* sample);
+
+// Открывает и запускает счётчики вызывающего потока
+void perf_start(PerfCounters* counters);
+
+// Останавливает и закрывает счётчики, добавляя их значения и время к sample
+void perf_stop(PerfCounters* counters, PerfSample* sample);
+
+const char* perf_event_name(PerfEvent event);
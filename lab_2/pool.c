@@ -0,0 +1,336 @@
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pool.h"
+
+typedef struct Task {
+    TaskFunc func;
+    void* arg;
+    TaskGroup* group;
+    struct Task* next;
+} Task;
+
+struct ThreadPool {
+    pthread_t* threads;
+    int* cpus;          // процессор для каждого потока, -1 — без закрепления
+    int workers;
+    int max_running;
+    int running;
+    int stop;
+    Task* head;
+    Task* tail;
+    pthread_mutex_t lock;
+    pthread_cond_t has_task;
+    pthread_cond_t task_done;
+};
+
+typedef struct {
+    ThreadPool* pool;
+    int index;
+} WorkerArgs;
+
+// Пул, которому принадлежит текущий поток (у остальных потоков NULL)
+static __thread ThreadPool* current_pool = NULL;
+// Пул, задачу которого сейчас выполняет посторонний поток (из pool_wait)
+static __thread ThreadPool* running_pool = NULL;
+
+static const char* const pin_names[] = {"none", "compact", "scatter"};
+
+int pool_parse_pin(const char* name) {
+    for (int p = 0; p < (int)(sizeof(pin_names) / sizeof(pin_names[0])); ++p) {
+        if (strcmp(name, pin_names[p]) == 0) {
+            return p;
+        }
+    }
+    return -1;
+}
+
+int pool_cpu_count(void) {
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return 1;
+    }
+    int count = CPU_COUNT(&set);
+    return count > 0 ? count : 1;
+}
+
+typedef struct {
+    int cpu;
+    int package;
+    int core;
+    int sibling;    // номер логического ядра внутри физического
+    int core_rank;  // номер физического ядра внутри сокета
+} CpuInfo;
+
+static int read_topology(int cpu, const char* name) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        return 0;
+    }
+    int value = 0;
+    if (fscanf(f, "%d", &value) != 1) {
+        value = 0;
+    }
+    fclose(f);
+    return value;
+}
+
+static int cmp_compact(const void* a, const void* b) {
+    const CpuInfo* x = a;
+    const CpuInfo* y = b;
+    if (x->package != y->package) return x->package - y->package;
+    if (x->core != y->core) return x->core - y->core;
+    return x->cpu - y->cpu;
+}
+
+static int cmp_scatter(const void* a, const void* b) {
+    const CpuInfo* x = a;
+    const CpuInfo* y = b;
+    if (x->sibling != y->sibling) return x->sibling - y->sibling;
+    if (x->core_rank != y->core_rank) return x->core_rank - y->core_rank;
+    if (x->package != y->package) return x->package - y->package;
+    return x->cpu - y->cpu;
+}
+
+// Порядок процессоров из маски процесса согласно политике; возвращает их число (0 — порядок неизвестен)
+static int cpu_order(PinPolicy pin, int** out) {
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return 0;
+    }
+    int count = 0;
+    CpuInfo* info = malloc(CPU_COUNT(&set) * sizeof(CpuInfo));
+    if (info == NULL) {
+        return 0;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) {
+            info[count].cpu = cpu;
+            info[count].package = read_topology(cpu, "physical_package_id");
+            info[count].core = read_topology(cpu, "core_id");
+            ++count;
+        }
+    }
+
+    // В компактном порядке логические ядра одного физического стоят рядом,
+    // по нему же считаем номера внутри ядра и сокета для разбросанного порядка
+    qsort(info, count, sizeof(CpuInfo), cmp_compact);
+    int rank = 0;
+    for (int c = 0; c < count; ++c) {
+        if (c > 0 && info[c].package != info[c - 1].package) {
+            rank = 0;
+        } else if (c > 0 && info[c].core != info[c - 1].core) {
+            ++rank;
+        }
+        info[c].core_rank = rank;
+        info[c].sibling = (c > 0 && info[c].package == info[c - 1].package && info[c].core == info[c - 1].core)
+            ? info[c - 1].sibling + 1 : 0;
+    }
+    if (pin == PIN_SCATTER) {
+        qsort(info, count, sizeof(CpuInfo), cmp_scatter);
+    }
+
+    *out = malloc(count * sizeof(int));
+    if (*out == NULL) {
+        free(info);
+        return 0;
+    }
+    for (int c = 0; c < count; ++c) {
+        (*out)[c] = info[c].cpu;
+    }
+    free(info);
+    return count;
+}
+
+static Task* pop_task(ThreadPool* pool) {
+    Task* task = pool->head;
+    if (task != NULL) {
+        pool->head = task->next;
+        if (pool->head == NULL) {
+            pool->tail = NULL;
+        }
+    }
+    return task;
+}
+
+// Берёт задачу из очереди, если не превышен предел одновременно работающих.
+// Вызывается под блокировкой.
+static Task* take_task(ThreadPool* pool) {
+    if (pool->running >= pool->max_running) {
+        return NULL;
+    }
+    Task* task = pop_task(pool);
+    if (task != NULL) {
+        ++pool->running;
+    }
+    return task;
+}
+
+// Выполняет задачу вне блокировки и отмечает её завершение.
+// counted — задача занимала место среди max_running.
+static void run_task(ThreadPool* pool, Task* task, int counted) {
+    pthread_mutex_unlock(&pool->lock);
+    ThreadPool* outer = running_pool;
+    if (current_pool != pool) {
+        running_pool = pool;
+    }
+    task->func(task->arg);
+    running_pool = outer;
+    pthread_mutex_lock(&pool->lock);
+    if (counted) {
+        --pool->running;
+    }
+    if (task->group != NULL) {
+        --task->group->pending;
+    }
+    free(task);
+    pthread_cond_broadcast(&pool->task_done);
+    pthread_cond_signal(&pool->has_task);
+}
+
+static void* Worker(void* arg) {
+    WorkerArgs* args = (WorkerArgs*) arg;
+    ThreadPool* pool = args->pool;
+    int cpu = pool->cpus ? pool->cpus[args->index] : -1;
+    free(args);
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    current_pool = pool;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        Task* task = take_task(pool);
+        if (task != NULL) {
+            run_task(pool, task, 1);
+            continue;
+        }
+        if (pool->stop) {
+            break;
+        }
+        pthread_cond_wait(&pool->has_task, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ThreadPool* pool_create(int workers, int max_running, PinPolicy pin) {
+    ThreadPool* pool = calloc(1, sizeof(ThreadPool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->workers = workers;
+    pool->max_running = max_running > 0 ? max_running : workers;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->has_task, NULL);
+    pthread_cond_init(&pool->task_done, NULL);
+
+    if (pin != PIN_NONE) {
+        int* order = NULL;
+        int count = cpu_order(pin, &order);
+        // Потоков больше, чем процессоров: закреплённые по кругу потоки делили бы процессоры,
+        // а планировщик разложит их равномернее
+        if (count > 0 && workers <= count) {
+            pool->cpus = malloc(workers * sizeof(int));
+            for (int w = 0; pool->cpus != NULL && w < workers; ++w) {
+                pool->cpus[w] = order[w];
+            }
+        }
+        free(order);
+    }
+
+    pool->threads = malloc(workers * sizeof(pthread_t));
+    if (pool->threads == NULL) {
+        pool->workers = 0;
+    }
+    for (int w = 0; w < pool->workers; ++w) {
+        WorkerArgs* args = malloc(sizeof(WorkerArgs));
+        if (args == NULL) {
+            pool->workers = w;
+            break;
+        }
+        args->pool = pool;
+        args->index = w;
+        if (pthread_create(&pool->threads[w], NULL, Worker, args) != 0) {
+            free(args);
+            pool->workers = w;
+            break;
+        }
+    }
+    if (pool->workers == 0) {
+        pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void pool_destroy(ThreadPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->has_task);
+    pthread_mutex_unlock(&pool->lock);
+    for (int w = 0; w < pool->workers; ++w) {
+        pthread_join(pool->threads[w], NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->has_task);
+    pthread_cond_destroy(&pool->task_done);
+    free(pool->threads);
+    free(pool->cpus);
+    free(pool);
+}
+
+int pool_workers(const ThreadPool* pool) {
+    return pool->workers;
+}
+
+void pool_submit(ThreadPool* pool, TaskGroup* group, TaskFunc func, void* arg) {
+    Task* task = malloc(sizeof(Task));
+    if (task == NULL) {
+        // Без места в очереди задача выполняется сразу в вызывающем потоке: группа её не ждёт
+        func(arg);
+        return;
+    }
+    task->func = func;
+    task->arg = arg;
+    task->group = group;
+    task->next = NULL;
+    pthread_mutex_lock(&pool->lock);
+    if (group != NULL) {
+        ++group->pending;
+    }
+    if (pool->tail != NULL) {
+        pool->tail->next = task;
+    } else {
+        pool->head = task;
+    }
+    pool->tail = task;
+    pthread_cond_signal(&pool->has_task);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void pool_wait(ThreadPool* pool, TaskGroup* group) {
+    pthread_mutex_lock(&pool->lock);
+    // Поток пула или посторонний поток внутри задачи пула уже занимает место среди работающих,
+    // и подзадачу он выполняет на этом же месте: иначе ожидающий мог бы занять все места
+    // и оставить свободные потоки без права взять его же подзадачи
+    int holds_slot = current_pool == pool || running_pool == pool;
+    while (group->pending > 0) {
+        Task* task = holds_slot ? pop_task(pool) : take_task(pool);
+        if (task != NULL) {
+            run_task(pool, task, !holds_slot);
+            continue;
+        }
+        pthread_cond_wait(&pool->task_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+// Постоянный пул потоков. Потоки создаются один раз и закрепляются за ядрами,
+// задачи ставятся в общую очередь, а одновременно выполняется не больше max_running задач.
+
+typedef enum {
+    PIN_NONE,    // не закреплять
+    PIN_COMPACT, // подряд: сначала все логические ядра одного физического ядра и сокета
+    PIN_SCATTER  // вразброс: по одному потоку на физическое ядро, сокеты по очереди
+} PinPolicy;
+
+typedef struct ThreadPool ThreadPool;
+
+// Группа задач, завершения которых можно дождаться. Инициализируется нулями.
+typedef struct {
+    int pending;
+} TaskGroup;
+
+typedef void (*TaskFunc)(void* arg);
+
+// Число процессоров, доступных процессу (sched_getaffinity)
+int pool_cpu_count(void);
+
+// Разбор имени политики ("none", "compact", "scatter"), -1 — неизвестное имя
+int pool_parse_pin(const char* name);
+
+ThreadPool* pool_create(int workers, int max_running, PinPolicy pin);
+void pool_destroy(ThreadPool* pool);
+
+int pool_workers(const ThreadPool* pool);
+
+void pool_submit(ThreadPool* pool, TaskGroup* group, TaskFunc func, void* arg);
+
+// Ждёт завершения всех задач группы. Пока ждёт, сам выполняет задачи из очереди,
+// поэтому задачи пула могут ставить подзадачи и ждать их без взаимной блокировки.
+void pool_wait(ThreadPool* pool, TaskGroup* group);
@@ -0,0 +1,247 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "procs.h"
+#include "engine.h"
+#include "hull.h"
+
+// Кусков на процесс: как и у потоков, десятки кусков выравнивают время окончания
+#define PROCS_CHUNKS_PER_PROC 64
+
+// Ответ работника; номера — позиции в общей памяти точек
+typedef struct {
+    Triangle best;
+    long long triples;
+    int chunks;         // пройдено кусков
+    int done;           // 1 — ответ записан целиком
+} ProcsSlot;
+
+// Управление перебором: отображается до fork без имени и достаётся работникам по тому же адресу
+typedef struct {
+    atomic_int next_chunk;
+    atomic_uint bound;  // общий порог отсечения: биты float, как Engine::shared_best
+    int chunk_count;
+    // По слоту на работника, следом chunk_count номеров работников, взявших кусок (-1 — никто)
+    ProcsSlot slots[];
+} ProcsControl;
+
+static int* chunk_owners(ProcsControl* control, int procs) {
+    return (int*)(control->slots + procs);
+}
+
+static float bits_float(unsigned bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void raise_bound(ProcsControl* control, float value) {
+    unsigned bits;
+    memcpy(&bits, &value, sizeof(bits));
+    unsigned old = atomic_load_explicit(&control->bound, memory_order_relaxed);
+    while (old < bits && !atomic_compare_exchange_weak_explicit(&control->bound, &old, bits,
+                                                                memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+// Тело работника. Точки открываются заново по имени только для чтения, а engine_init копирует
+// их в структуру массивов в памяти самого работника. Номер куска записывается до перебора,
+// поэтому после падения работника известно, какие куски перебрать заново.
+static int procs_worker(const char* name, int n, const EngineConfig* config, ProcsControl* control,
+                        const Chunk* chunks, int index, int procs) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd == -1) {
+        return -1;
+    }
+    void* map = mmap(NULL, (size_t)n * 3 * sizeof(float), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+    Engine engine;
+    Scan scan;
+    if (engine_init(&engine, (const float (*)[3])map, NULL, n, config) != 0 || scan_init(&scan, &engine) != 0) {
+        return -1;
+    }
+    int* owners = chunk_owners(control, procs);
+    ProcsSlot* slot = &control->slots[index];
+    int c;
+    while ((c = atomic_fetch_add(&control->next_chunk, 1)) < control->chunk_count) {
+        owners[c] = index;
+        engine_raise_bound(&engine, bits_float(atomic_load_explicit(&control->bound, memory_order_relaxed)));
+        engine_scan_chunk(&engine, &chunks[c], &scan);
+        raise_bound(control, engine_bound(&engine));
+        ++slot->chunks;
+    }
+    slot->best = (Triangle){scan.best, scan.i, scan.j, scan.k};
+    slot->triples = scan.triples;
+    slot->done = 1;
+    return 0;
+}
+
+int procs_find(const float (*xyz)[3], int n, int procs, const maxtri_opts* opts, maxtri_result* out, int* failed) {
+    memset(out, 0, sizeof(maxtri_result));
+    out->best.i = out->best.j = out->best.k = -1;
+    out->ratio = 1.0;
+    out->coverage = 1.0;
+    *failed = 0;
+    if (n < 3 || procs < 1 || opts->top_k > 1 || opts->approx_eps > 0.0 || opts->quantize
+        || opts->deadline_ms != 0 || opts->progress != NULL || opts->perf) {
+        return MAXTRI_EINVAL;
+    }
+    EngineConfig config;
+    config.row_kernel = kernel_get(opts->kernel);
+    config.norm_kernel = kernel_norms_get(opts->kernel);
+    if (config.row_kernel == NULL || config.norm_kernel == NULL) {
+        return MAXTRI_EKERNEL;
+    }
+    kernel_tile_sizes(&config.tile_j, &config.tile_k);
+    if (opts->tile >= 0) {
+        config.tile_k = opts->tile;
+    }
+    config.prune = opts->prune;
+    config.top_k = 1;
+
+    // Работники получают уже отобранные точки, а номера переводятся обратно здесь
+    int* ids = NULL;
+    if (opts->backend == MAXTRI_HULL) {
+        ids = malloc(n * sizeof(int));
+        if (ids == NULL) {
+            return MAXTRI_ENOMEM;
+        }
+        n = hull_vertices_parallel(xyz, n, opts->pool, ids);
+        out->hull_count = n;
+    }
+    out->candidates = n;
+
+    Chunk* chunks = NULL;
+    int chunk_count = schedule_build(n, (long long)procs * PROCS_CHUNKS_PER_PROC, &chunks);
+    size_t points_size = (size_t)n * 3 * sizeof(float);
+    size_t control_size = sizeof(ProcsControl) + procs * sizeof(ProcsSlot) + (chunk_count > 0 ? chunk_count : 1) * sizeof(int);
+    char name[64];
+    snprintf(name, sizeof(name), "/maxtri-%d", (int)getpid());
+    shm_unlink(name);
+    float (*points)[3] = MAP_FAILED;
+    ProcsControl* control = MAP_FAILED;
+    pid_t* pids = malloc(procs * sizeof(pid_t));
+    int* ok = calloc(procs, sizeof(int));
+    int status = MAXTRI_OK;
+    if (chunks == NULL || pids == NULL || ok == NULL) {
+        status = MAXTRI_ENOMEM;
+        goto done;
+    }
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd == -1) {
+        status = MAXTRI_EPROC;
+        goto done;
+    }
+    if (ftruncate(fd, points_size) == 0) {
+        points = mmap(NULL, points_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    control = mmap(NULL, control_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (points == MAP_FAILED || control == MAP_FAILED) {
+        status = MAXTRI_EPROC;
+        goto done;
+    }
+    for (int p = 0; p < n; ++p) {
+        memcpy(points[p], xyz[ids ? ids[p] : p], sizeof(points[p]));
+    }
+    atomic_init(&control->next_chunk, 0);
+    atomic_init(&control->bound, 0);
+    control->chunk_count = chunk_count;
+    int* owners = chunk_owners(control, procs);
+    for (int c = 0; c < chunk_count; ++c) {
+        owners[c] = -1;
+    }
+
+    // Работник не возвращается в вызывающий код: _exit не сбрасывает унаследованные буферы stdio
+    for (int w = 0; w < procs; ++w) {
+        pids[w] = fork();
+        if (pids[w] == 0) {
+            _exit(procs_worker(name, n, &config, control, chunks, w, procs) == 0 ? 0 : 1);
+        }
+    }
+    for (int w = 0; w < procs; ++w) {
+        int wstatus = 0;
+        if (pids[w] > 0) {
+            while (waitpid(pids[w], &wstatus, 0) == -1 && errno == EINTR) {
+            }
+            ok[w] = WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0 && control->slots[w].done;
+        }
+        *failed += !ok[w];
+    }
+
+    Triangle best = {0.0f, -1, -1, -1};
+    long long triples = 0;
+    for (int w = 0; w < procs; ++w) {
+        if (ok[w]) {
+            if (control->slots[w].best.i >= 0 && triangle_better(&control->slots[w].best, &best)) {
+                best = control->slots[w].best;
+            }
+            triples += control->slots[w].triples;
+        }
+    }
+    // Куски упавших работников и куски, которые никто не успел взять, перебираются здесь. Порог —
+    // только из ответов уцелевших: треугольник упавшего работника мог пропасть вместе с ним.
+    int lost = 0;
+    for (int c = 0; c < chunk_count; ++c) {
+        lost += owners[c] < 0 || !ok[owners[c]];
+    }
+    if (lost > 0) {
+        Engine engine;
+        Scan scan;
+        if (engine_init(&engine, (const float (*)[3])points, NULL, n, &config) != 0) {
+            status = MAXTRI_ENOMEM;
+            goto done;
+        }
+        if (scan_init(&scan, &engine) != 0) {
+            engine_free(&engine);
+            status = MAXTRI_ENOMEM;
+            goto done;
+        }
+        engine_raise_bound(&engine, best.cross2);
+        for (int c = 0; c < chunk_count; ++c) {
+            if (owners[c] < 0 || !ok[owners[c]]) {
+                engine_scan_chunk(&engine, &chunks[c], &scan);
+            }
+        }
+        Triangle found = {scan.best, scan.i, scan.j, scan.k};
+        if (found.i >= 0 && triangle_better(&found, &best)) {
+            best = found;
+        }
+        triples += scan.triples;
+        scan_free(&scan);
+        engine_free(&engine);
+    }
+    out->triples = triples;
+    if (best.i >= 0) {
+        out->best.area = 0.5 * sqrt(best.cross2);
+        out->best.i = ids ? ids[best.i] : best.i;
+        out->best.j = ids ? ids[best.j] : best.j;
+        out->best.k = ids ? ids[best.k] : best.k;
+    }
+
+done:
+    if (points != MAP_FAILED) {
+        munmap(points, points_size);
+    }
+    if (control != MAP_FAILED) {
+        munmap(control, control_size);
+    }
+    shm_unlink(name);
+    free(ok);
+    free(pids);
+    free(chunks);
+    free(ids);
+    return status;
+}
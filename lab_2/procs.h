@@ -0,0 +1,14 @@
+#pragma once
+
+#include "maxtri.h"
+
+// Перебор в нескольких процессах вместо потоков: у каждого работника свой распределитель памяти,
+// и падение одного не роняет остальных. Точки лежат в общей памяти shm_open, работники
+// отображают их только для чтения. Куски перебора раздаются общим атомарным счётчиком,
+// порог отсечения общий, а ответ каждый работник записывает в свой слот общего массива.
+
+// Перебор n точек xyz в procs процессах, запущенных fork. С MAXTRI_HULL оболочка строится
+// до запуска на opts->pool. Куски работника, завершившегося с ошибкой или сигналом, перебираются
+// заново в вызывающем процессе, а число таких работников записывается в failed.
+// --top, приближённый поиск, --quantize, срок, снимки и счётчики не поддерживаются.
+int procs_find(const float (*xyz)[3], int n, int procs, const maxtri_opts* opts, maxtri_result* out, int* failed);
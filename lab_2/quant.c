@@ -0,0 +1,356 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "quant.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define QUANT_X86 1
+#endif
+
+// Относительная ошибка max |u × w|: компоненты точны в int32, а перевод во float, квадраты
+// и сумма дают не больше нескольких единиц 2^-24
+#define QUANT_REL_ERR 1e-6
+
+static int16_t quantize(float value, double center, double scale) {
+    long q = lround((value - center) / scale);
+    return (int16_t)(q > QUANT_MAX ? QUANT_MAX : (q < -QUANT_MAX ? -QUANT_MAX : q));
+}
+
+int quant_init(QuantPoints* qp, const PointsSoA* ps) {
+    int n = ps->n;
+    memset(qp, 0, sizeof(QuantPoints));
+    qp->x = malloc((n > 0 ? n : 1) * sizeof(int16_t));
+    qp->y = malloc((n > 0 ? n : 1) * sizeof(int16_t));
+    qp->z = malloc((n > 0 ? n : 1) * sizeof(int16_t));
+    if (qp->x == NULL || qp->y == NULL || qp->z == NULL) {
+        quant_free(qp);
+        return -1;
+    }
+    qp->n = n;
+    // Один шаг по всем осям, иначе векторное произведение квантованных векторов не пропорционально исходному
+    const float* axes[3] = {ps->x, ps->y, ps->z};
+    double center[3], half = 0.0, diameter2 = 0.0;
+    for (int d = 0; d < 3; ++d) {
+        double lo = n > 0 ? axes[d][0] : 0.0, hi = lo;
+        for (int p = 1; p < n; ++p) {
+            if (axes[d][p] < lo) lo = axes[d][p];
+            if (axes[d][p] > hi) hi = axes[d][p];
+        }
+        center[d] = (lo + hi) / 2;
+        diameter2 += (hi - lo) * (hi - lo);
+        if ((hi - lo) / 2 > half) half = (hi - lo) / 2;
+    }
+    qp->scale = half > 0.0 ? half / QUANT_MAX : 1.0;
+    // Разность двух квантованных координат отличается от исходной не больше чем на s, вектор — на √3·s
+    qp->delta = 2.0 * sqrt(3.0) * qp->scale * sqrt(diameter2) + 3.0 * qp->scale * qp->scale;
+    // Как в bounds_init: квадрат площади не больше D^4, ошибка ядра — малая доля от этого
+    qp->slack = 1e-5 * diameter2 * diameter2;
+    for (int p = 0; p < n; ++p) {
+        qp->x[p] = quantize(ps->x[p], center[0], qp->scale);
+        qp->y[p] = quantize(ps->y[p], center[1], qp->scale);
+        qp->z[p] = quantize(ps->z[p], center[2], qp->scale);
+    }
+    return 0;
+}
+
+void quant_free(QuantPoints* qp) {
+    free(qp->x);
+    free(qp->y);
+    free(qp->z);
+    qp->x = qp->y = qp->z = NULL;
+}
+
+static float quant_row_scalar(const QuantPoints* qp, int i, int j, int k_begin, int k_end) {
+    int ux = qp->x[j] - qp->x[i], uy = qp->y[j] - qp->y[i], uz = qp->z[j] - qp->z[i];
+    float best = 0.0f;
+    for (int k = k_begin; k < k_end; ++k) {
+        int wx = qp->x[k] - qp->x[i], wy = qp->y[k] - qp->y[i], wz = qp->z[k] - qp->z[i];
+        float cx = (float)(uy * wz - uz * wy);
+        float cy = (float)(uz * wx - ux * wz);
+        float cz = (float)(ux * wy - uy * wx);
+        float s = cx * cx + cy * cy + cz * cz;
+        if (s > best) best = s;
+    }
+    return best;
+}
+
+#ifdef QUANT_X86
+// Множитель для madd: пара (w_a, w_b) даёт lo · w_a + hi · w_b одной компонентой в int32
+static inline int pack_pair(int lo, int hi) {
+    return (int)((uint32_t)(uint16_t)lo | ((uint32_t)(uint16_t)hi << 16));
+}
+
+__attribute__((target("avx2")))
+static float quant_row_avx2(const QuantPoints* qp, int i, int j, int k_begin, int k_end) {
+    const int16_t* x = qp->x;
+    const int16_t* y = qp->y;
+    const int16_t* z = qp->z;
+    int ux = x[j] - x[i], uy = y[j] - y[i], uz = z[j] - z[i];
+    __m256i ix = _mm256_set1_epi16(x[i]), iy = _mm256_set1_epi16(y[i]), iz = _mm256_set1_epi16(z[i]);
+    // cx = uy·wz - uz·wy, cy = uz·wx - ux·wz, cz = ux·wy - uy·wx
+    __m256i mx = _mm256_set1_epi32(pack_pair(uy, -uz));
+    __m256i my = _mm256_set1_epi32(pack_pair(uz, -ux));
+    __m256i mz = _mm256_set1_epi32(pack_pair(ux, -uy));
+    __m256 vbest = _mm256_setzero_ps();
+    int k = k_begin;
+    for (; k + 16 <= k_end; k += 16) {
+        __m256i wx = _mm256_sub_epi16(_mm256_loadu_si256((const __m256i*)(x + k)), ix);
+        __m256i wy = _mm256_sub_epi16(_mm256_loadu_si256((const __m256i*)(y + k)), iy);
+        __m256i wz = _mm256_sub_epi16(_mm256_loadu_si256((const __m256i*)(z + k)), iz);
+        // Половины lo и hi — разные восьмёрки k; порядок k для максимума не важен
+        __m256i zy_lo = _mm256_unpacklo_epi16(wz, wy), zy_hi = _mm256_unpackhi_epi16(wz, wy);
+        __m256i xz_lo = _mm256_unpacklo_epi16(wx, wz), xz_hi = _mm256_unpackhi_epi16(wx, wz);
+        __m256i yx_lo = _mm256_unpacklo_epi16(wy, wx), yx_hi = _mm256_unpackhi_epi16(wy, wx);
+        __m256 cx = _mm256_cvtepi32_ps(_mm256_madd_epi16(zy_lo, mx));
+        __m256 cy = _mm256_cvtepi32_ps(_mm256_madd_epi16(xz_lo, my));
+        __m256 cz = _mm256_cvtepi32_ps(_mm256_madd_epi16(yx_lo, mz));
+        __m256 s = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, cx), _mm256_mul_ps(cy, cy)), _mm256_mul_ps(cz, cz));
+        vbest = _mm256_max_ps(vbest, s);
+        cx = _mm256_cvtepi32_ps(_mm256_madd_epi16(zy_hi, mx));
+        cy = _mm256_cvtepi32_ps(_mm256_madd_epi16(xz_hi, my));
+        cz = _mm256_cvtepi32_ps(_mm256_madd_epi16(yx_hi, mz));
+        s = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, cx), _mm256_mul_ps(cy, cy)), _mm256_mul_ps(cz, cz));
+        vbest = _mm256_max_ps(vbest, s);
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, vbest);
+    float best = quant_row_scalar(qp, i, j, k, k_end);
+    for (int l = 0; l < 8; ++l) {
+        if (lanes[l] > best) best = lanes[l];
+    }
+    return best;
+}
+#endif
+
+QuantKernel quant_kernel_get(KernelKind kind) {
+#ifdef QUANT_X86
+    if (kind == KERNEL_AUTO || kind == KERNEL_AVX2 || kind == KERNEL_AVX512) {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return quant_row_avx2;
+        }
+    }
+#else
+    (void)kind;
+#endif
+    return quant_row_scalar;
+}
+
+typedef struct {
+    int i, j;
+    double upper;       // оценка сверху |U × W| по третьим вершинам пары
+} QuantPair;
+
+typedef struct {
+    Engine* engine;
+    const QuantPoints* qp;
+    QuantKernel kernel;
+    // Первый проход: куски engine->chunks, второй — пары pairs
+    const QuantPair* pairs;
+    int pair_count;
+    atomic_int next;
+} QuantJob;
+
+typedef struct {
+    QuantJob* job;
+    QuantPair* kept;    // пары потока, прошедшие отбор по текущему порогу
+    int kept_count, kept_cap;
+    Scan scan;
+    int failed;
+    PerfSample* perf;   // NULL — без счётчиков
+    TaskFunc pass;      // проход, который выполняет задача
+} QuantTask;
+
+// Границы |U × W| для пары по max |u × w| в единицах шага
+static void pair_bounds(const QuantPoints* qp, float max2, double* lower, double* upper) {
+    double m = sqrt((double)max2) * qp->scale * qp->scale;
+    *upper = m * (1.0 + QUANT_REL_ERR) + qp->delta;
+    *lower = m * (1.0 - QUANT_REL_ERR) - qp->delta;
+}
+
+// Пара нужна точному перебору, если её оценка сверху с запасом на округление ядра не меньше порога
+static int pair_hopeless(Engine* engine, const QuantPoints* qp, double upper) {
+    return upper * upper + qp->slack < engine_bound(engine);
+}
+
+static void filter_chunk(QuantTask* task, const Chunk* chunk) {
+    Engine* engine = task->job->engine;
+    const QuantPoints* qp = task->job->qp;
+    const PointsSoA* ps = &engine->points;
+    int n = ps->n;
+    int i = chunk->i;
+    int prune = engine->config.prune;
+    if (prune && bound_row(&engine->bounds, i) + engine->bounds.slack < engine_bound(engine)) {
+        return;
+    }
+    for (int j = chunk->j_begin; j < chunk->j_end; ++j) {
+        int k_begin = j + 1 > engine->fresh ? j + 1 : engine->fresh;
+        if (k_begin >= n) {
+            continue;
+        }
+        if (prune) {
+            double dx = (double)ps->x[j] - ps->x[i], dy = (double)ps->y[j] - ps->y[i], dz = (double)ps->z[j] - ps->z[i];
+            if (bound_pair(&engine->bounds, i, dx * dx + dy * dy + dz * dz) + engine->bounds.slack < engine_bound(engine)) {
+                continue;
+            }
+        }
+        double lower, upper;
+        pair_bounds(qp, task->job->kernel(qp, i, j, k_begin, n), &lower, &upper);
+        task->scan.triples += n - k_begin;
+        // Треугольник с площадью не меньше lower точно есть, поэтому им можно поднять порог.
+        // Запас покрывает разницу между точным квадратом и квадратом, посчитанным ядром во float.
+        if (lower > 0.0) {
+            engine_raise_bound(engine, (float)(lower * lower * (1.0 - 1e-5)));
+        }
+        if (pair_hopeless(engine, qp, upper)) {
+            continue;
+        }
+        if (task->kept_count == task->kept_cap) {
+            task->kept_cap = task->kept_cap ? task->kept_cap * 2 : 256;
+            QuantPair* grown = realloc(task->kept, task->kept_cap * sizeof(QuantPair));
+            if (grown == NULL) {
+                task->failed = 1;
+                return;
+            }
+            task->kept = grown;
+        }
+        task->kept[task->kept_count++] = (QuantPair){i, j, upper};
+    }
+}
+
+static void QuantFilterWorker(void* arg) {
+    QuantTask* task = (QuantTask*) arg;
+    QuantJob* job = task->job;
+    int c;
+    while ((c = atomic_fetch_add(&job->next, 1)) < job->engine->chunk_count) {
+        filter_chunk(task, &job->engine->chunks[c]);
+    }
+}
+
+static void QuantExactWorker(void* arg) {
+    QuantTask* task = (QuantTask*) arg;
+    QuantJob* job = task->job;
+    int p;
+    while ((p = atomic_fetch_add(&job->next, 1)) < job->pair_count) {
+        Chunk pair = {job->pairs[p].i, job->pairs[p].j, job->pairs[p].j + 1};
+        engine_scan_chunk(job->engine, &pair, &task->scan);
+    }
+}
+
+static int cmp_pair(const void* a, const void* b) {
+    const QuantPair* x = (const QuantPair*)a;
+    const QuantPair* y = (const QuantPair*)b;
+    if (x->i != y->i) return (x->i > y->i) - (x->i < y->i);
+    return (x->j > y->j) - (x->j < y->j);
+}
+
+// Проход задачи со счётчиками потока
+static void QuantMeasured(void* arg) {
+    QuantTask* task = (QuantTask*) arg;
+    if (task->perf == NULL) {
+        task->pass(task);
+        return;
+    }
+    PerfCounters counters;
+    long long triples = task->scan.triples;
+    perf_start(&counters);
+    task->pass(task);
+    perf_stop(&counters, task->perf);
+    task->perf->triples += task->scan.triples - triples;
+}
+
+// Запуск задач func на пуле или, при threads == 1, в вызывающем потоке
+static void run_tasks(ThreadPool* pool, int threads, TaskFunc func, QuantTask* tasks) {
+    for (int t = 0; t < threads; ++t) {
+        tasks[t].pass = func;
+    }
+    atomic_store(&tasks[0].job->next, 0);
+    if (pool == NULL || threads <= 1) {
+        QuantMeasured(&tasks[0]);
+        return;
+    }
+    TaskGroup group = {0};
+    for (int t = 0; t < threads; ++t) {
+        pool_submit(pool, &group, QuantMeasured, &tasks[t]);
+    }
+    pool_wait(pool, &group);
+}
+
+int quant_run(Engine* engine, QuantKernel kernel, ThreadPool* pool, int threads, Scan* out, QuantStats* stats) {
+    int n = engine->points.n;
+    if (pool == NULL || threads < 1) {
+        threads = 1;
+    }
+    stats->pairs = (long long)n * (n - 1) / 2;
+    stats->kept = 0;
+    if (n < 3) {
+        return 0;
+    }
+    QuantPoints qp;
+    if (quant_init(&qp, &engine->points) != 0) {
+        return -1;
+    }
+    QuantJob job = {engine, &qp, kernel, NULL, 0, 0};
+    atomic_init(&job.next, 0);
+    QuantTask* tasks = calloc(threads, sizeof(QuantTask));
+    free(engine->chunks);
+    engine->chunk_count = schedule_build(n, threads * 64LL, &engine->chunks);
+    if (tasks == NULL || engine->chunk_count < 0) {
+        free(tasks);
+        quant_free(&qp);
+        return -1;
+    }
+    int status = 0;
+    for (int t = 0; t < threads; ++t) {
+        tasks[t].job = &job;
+        tasks[t].perf = engine->perf ? &engine->perf[t] : NULL;
+        if (scan_init(&tasks[t].scan, engine) != 0) {
+            status = -1;
+        }
+    }
+
+    // Первый проход: пары, которые по квантованным точкам ещё могут дать ответ
+    QuantPair* pairs = NULL;
+    if (status == 0) {
+        run_tasks(pool, threads, QuantFilterWorker, tasks);
+        long long total = 0;
+        for (int t = 0; t < threads; ++t) {
+            total += tasks[t].kept_count;
+            status |= -tasks[t].failed;
+        }
+        pairs = malloc((total > 0 ? total : 1) * sizeof(QuantPair));
+        if (pairs == NULL) {
+            status = -1;
+        }
+    }
+    // Порог к концу прохода мог вырасти, поэтому пары отбираются ещё раз
+    if (status == 0) {
+        for (int t = 0; t < threads; ++t) {
+            for (int p = 0; p < tasks[t].kept_count; ++p) {
+                if (!pair_hopeless(engine, &qp, tasks[t].kept[p].upper)) {
+                    pairs[job.pair_count++] = tasks[t].kept[p];
+                }
+            }
+        }
+        // Пары по порядку (i, j), как при полном переборе: при равных площадях побеждают меньшие номера
+        qsort(pairs, job.pair_count, sizeof(QuantPair), cmp_pair);
+        stats->kept = job.pair_count;
+
+        // Второй проход: точный перебор оставшихся пар во float
+        job.pairs = pairs;
+        run_tasks(pool, threads, QuantExactWorker, tasks);
+        for (int t = 0; t < threads; ++t) {
+            scan_merge(out, &tasks[t].scan);
+        }
+    }
+
+    for (int t = 0; t < threads; ++t) {
+        free(tasks[t].kept);
+        scan_free(&tasks[t].scan);
+    }
+    free(tasks);
+    free(pairs);
+    quant_free(&qp);
+    return status;
+}
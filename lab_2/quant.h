@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include "engine.h"
+
+// Предварительный отбор пар (i, j) по координатам, квантованным в int16: в векторе и строке кэша
+// их вдвое больше, чем float. Для каждой пары по квантованным точкам считается max |u × w|
+// по третьим вершинам, а оценки ошибки квантования дают для неё границы площади сверху и снизу.
+// Точный перебор во float идёт только по парам, у которых оценка сверху не меньше лучшей
+// оценки снизу, поэтому ответ совпадает с полным перебором.
+
+// Координата хранится в QUANT_BITS битах со знаком, так что разность двух координат
+// и произведения разностей (через madd в int32) не переполняются
+#define QUANT_BITS 14
+#define QUANT_MAX ((1 << (QUANT_BITS - 1)) - 1)
+
+typedef struct {
+    int16_t* x;
+    int16_t* y;
+    int16_t* z;
+    int n;
+    double scale;   // шаг s: точка ≈ центр + s · q, ошибка каждой координаты не больше s / 2
+    double delta;   // |U × W - s² (u × w)| ≤ 2√3 · s · D + 3s², где D — диагональ рамки точек
+    double slack;   // запас на ошибку округления, с которой ядро считает квадрат во float
+} QuantPoints;
+
+// max по k из [k_begin, k_end) квадрата |u × w| в единицах шага, u = q_j - q_i, w = q_k - q_i
+typedef float (*QuantKernel)(const QuantPoints* qp, int i, int j, int k_begin, int k_end);
+
+// Квантует точки ps с общим для всех осей шагом относительно центра их рамки
+int quant_init(QuantPoints* qp, const PointsSoA* ps);
+void quant_free(QuantPoints* qp);
+
+// Ядро на AVX2 (madd по парам int16), если kind его допускает и процессор поддерживает, иначе скалярное
+QuantKernel quant_kernel_get(KernelKind kind);
+
+typedef struct {
+    long long pairs;    // всех пар (i, j)
+    long long kept;     // пар, прошедших отбор к точному перебору
+} QuantStats;
+
+// Перебор engine (top_k == 1) в два прохода: отбор пар по квантованным точкам и точный перебор
+// оставшихся пар тем же engine_scan_chunk. При threads > 1 оба прохода идут на пуле.
+int quant_run(Engine* engine, QuantKernel kernel, ThreadPool* pool, int threads, Scan* out, QuantStats* stats);
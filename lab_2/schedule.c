@@ -0,0 +1,57 @@
+#include <stdlib.h>
+#include "schedule.h"
+
+long long chunk_cost(const Chunk* chunk, int n) {
+    // Для пары (i, j) третьих вершин n - 1 - j, сумма по j — арифметическая прогрессия
+    long long first = n - 1 - chunk->j_begin;
+    long long last = n - chunk->j_end;
+    return (first + last) * (chunk->j_end - chunk->j_begin) / 2;
+}
+
+int schedule_build(int n, long long target_chunks, Chunk** out) {
+    // Число троек от двух миллионов точек не помещается в long long, поэтому размер куска
+    // считается в double; кусок больше строки (меньше n * n троек) ничего не меняет
+    double total = (double)n * (n - 1) * (n - 2) / 6;
+    double per_chunk = target_chunks > 0 ? total / target_chunks : total;
+    long long target = per_chunk < (double)n * n ? (long long)per_chunk : (long long)n * n;
+    if (target < 1) {
+        target = 1;
+    }
+
+    int cap = n + 1024;
+    int count = 0;
+    Chunk* chunks = malloc(cap * sizeof(Chunk));
+    *out = NULL;
+    if (chunks == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < n - 2; ++i) {
+        int j = i + 1;
+        while (j < n - 1) {
+            // Наименьшее число пар t, для которого m + (m - 1) + ... + (m - t + 1) >= target
+            long long m = n - 1 - j;
+            long long lo = 1, hi = m;
+            while (lo < hi) {
+                long long t = (lo + hi) / 2;
+                if (t * m - t * (t - 1) / 2 >= target) {
+                    hi = t;
+                } else {
+                    lo = t + 1;
+                }
+            }
+            if (count == cap) {
+                Chunk* grown = realloc(chunks, 2 * (size_t)cap * sizeof(Chunk));
+                if (grown == NULL) {
+                    free(chunks);
+                    return -1;
+                }
+                chunks = grown;
+                cap *= 2;
+            }
+            chunks[count++] = (Chunk){i, j, j + (int)lo};
+            j += (int)lo;
+        }
+    }
+    *out = chunks;
+    return count;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// Кусок работы: пары (i, j) при j из [j_begin, j_end), для каждой перебираются все k > j
+typedef struct {
+    int i;
+    int j_begin, j_end;
+} Chunk;
+
+// Число троек в куске
+long long chunk_cost(const Chunk* chunk, int n);
+
+// Делит все пары (i, j) для n точек на куски примерно по total / target_chunks троек.
+// Куски не пересекают строк i и идут в порядке возрастания (i, j), то есть от дорогих
+// строк к дешёвым. Возвращает число кусков, массив освобождается через free; -1 и *out == NULL,
+// если не хватило памяти.
+int schedule_build(int n, long long target_chunks, Chunk** out);
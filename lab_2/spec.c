@@ -0,0 +1,249 @@
+// Значения должны совпадать с kernel.c побитово, поэтому склейка в FMA запрещена. Без errno у sqrt
+// и с конечными значениями (вместо бесконечности — наибольшее число типа) внутренние циклы
+// spec_impl.h, включая свёртку лучшего значения, векторизуются при любом уровне оптимизации.
+// Конечность координат проверяют загрузчик и maxtri_find_points: nan сюда не доходит.
+#pragma GCC optimize("O3", "fp-contract=off", "no-math-errno", "finite-math-only", "no-signed-zeros")
+
+#include <float.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tgmath.h>
+#include "spec.h"
+#include "maxtri.h"
+#include "schedule.h"
+
+// Третьих вершин в блоке значений внутреннего цикла
+#define SPEC_BLOCK 256
+
+// Цели для #if в spec_impl.h: константы перечисления препроцессору не видны
+#define SPEC_MAX_AREA 0
+#define SPEC_MAX_PERIMETER 1
+#define SPEC_MIN_AREA 2
+_Static_assert(SPEC_MAX_AREA == MAXTRI_MAX_AREA && SPEC_MAX_PERIMETER == MAXTRI_MAX_PERIMETER
+               && SPEC_MIN_AREA == MAXTRI_MIN_AREA, "spec objectives must match maxtri_objective");
+
+typedef struct {
+    void* c[3];         // координаты в виде структуры массивов, тип зависит от сочетания
+    int n;
+    double cutoff;      // для MAXTRI_MIN_AREA: значения не больше него считаются вырожденными
+} SpecPoints;
+
+typedef struct {
+    double value;       // значение цели до перевода в площадь
+    int i, j, k;
+} SpecBest;
+
+typedef void (*SpecChunkScan)(const SpecPoints* sp, const Chunk* chunk, SpecBest* best);
+
+#define SPEC_CAT2(a, b) a##_##b
+#define SPEC_CAT(a, b) SPEC_CAT2(a, b)
+#define SPEC_FN(name) SPEC_CAT(name, SPEC_NAME)
+
+// Каждое сочетание собирается ещё и под AVX2; подходящий вариант выбирается при запуске
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define SPEC_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define SPEC_CLONES
+#endif
+
+#define SPEC_NAME area2f
+#define SPEC_DIM 2
+#define SPEC_T float
+#define SPEC_OBJECTIVE SPEC_MAX_AREA
+#include "spec_impl.h"
+
+#define SPEC_NAME perimeter2f
+#define SPEC_DIM 2
+#define SPEC_T float
+#define SPEC_OBJECTIVE SPEC_MAX_PERIMETER
+#include "spec_impl.h"
+
+#define SPEC_NAME min_area2f
+#define SPEC_DIM 2
+#define SPEC_T float
+#define SPEC_OBJECTIVE SPEC_MIN_AREA
+#include "spec_impl.h"
+
+#define SPEC_NAME area2d
+#define SPEC_DIM 2
+#define SPEC_T double
+#define SPEC_OBJECTIVE SPEC_MAX_AREA
+#include "spec_impl.h"
+
+#define SPEC_NAME perimeter2d
+#define SPEC_DIM 2
+#define SPEC_T double
+#define SPEC_OBJECTIVE SPEC_MAX_PERIMETER
+#include "spec_impl.h"
+
+#define SPEC_NAME min_area2d
+#define SPEC_DIM 2
+#define SPEC_T double
+#define SPEC_OBJECTIVE SPEC_MIN_AREA
+#include "spec_impl.h"
+
+#define SPEC_NAME area3f
+#define SPEC_DIM 3
+#define SPEC_T float
+#define SPEC_OBJECTIVE SPEC_MAX_AREA
+#include "spec_impl.h"
+
+#define SPEC_NAME perimeter3f
+#define SPEC_DIM 3
+#define SPEC_T float
+#define SPEC_OBJECTIVE SPEC_MAX_PERIMETER
+#include "spec_impl.h"
+
+#define SPEC_NAME min_area3f
+#define SPEC_DIM 3
+#define SPEC_T float
+#define SPEC_OBJECTIVE SPEC_MIN_AREA
+#include "spec_impl.h"
+
+#define SPEC_NAME area3d
+#define SPEC_DIM 3
+#define SPEC_T double
+#define SPEC_OBJECTIVE SPEC_MAX_AREA
+#include "spec_impl.h"
+
+#define SPEC_NAME perimeter3d
+#define SPEC_DIM 3
+#define SPEC_T double
+#define SPEC_OBJECTIVE SPEC_MAX_PERIMETER
+#include "spec_impl.h"
+
+#define SPEC_NAME min_area3d
+#define SPEC_DIM 3
+#define SPEC_T double
+#define SPEC_OBJECTIVE SPEC_MIN_AREA
+#include "spec_impl.h"
+
+// [dim - 2][double][objective]
+static const SpecChunkScan spec_scans[2][2][3] = {
+    {{spec_chunk_area2f, spec_chunk_perimeter2f, spec_chunk_min_area2f},
+     {spec_chunk_area2d, spec_chunk_perimeter2d, spec_chunk_min_area2d}},
+    {{spec_chunk_area3f, spec_chunk_perimeter3f, spec_chunk_min_area3f},
+     {spec_chunk_area3d, spec_chunk_perimeter3d, spec_chunk_min_area3d}},
+};
+
+// Лучшее значение цели, при равенстве — меньшие номера точек
+static void spec_merge(SpecBest* into, const SpecBest* from, int objective) {
+    if (from->i < 0) {
+        return;
+    }
+    int better = into->i < 0
+        || (objective == MAXTRI_MIN_AREA ? from->value < into->value : from->value > into->value);
+    if (!better && from->value == into->value) {
+        better = from->i != into->i ? from->i < into->i : (from->j != into->j ? from->j < into->j : from->k < into->k);
+    }
+    if (better) {
+        *into = *from;
+    }
+}
+
+typedef struct {
+    const SpecPoints* sp;
+    SpecChunkScan scan;
+    const Chunk* chunks;
+    int chunk_count;
+    atomic_int* next_chunk;
+    SpecBest best;
+} SpecTask;
+
+static void SpecWorker(void* arg) {
+    SpecTask* task = (SpecTask*) arg;
+    int c;
+    while ((c = atomic_fetch_add(task->next_chunk, 1)) < task->chunk_count) {
+        task->scan(task->sp, &task->chunks[c], &task->best);
+    }
+}
+
+int spec_find(const void* data, int n, int dim, int scalar_size, int objective,
+              ThreadPool* pool, int threads, SpecResult* out) {
+    out->value = 0.0;
+    out->i = out->j = out->k = -1;
+    if ((dim != 2 && dim != 3) || (scalar_size != sizeof(float) && scalar_size != sizeof(double))
+        || objective < MAXTRI_MAX_AREA || objective > MAXTRI_MIN_AREA) {
+        return -1;
+    }
+    SpecChunkScan scan = spec_scans[dim - 2][scalar_size == sizeof(double)][objective];
+
+    // Структура массивов: координаты копируются побайтно, без преобразования типа
+    SpecPoints sp = {{NULL, NULL, NULL}, n, 0.0};
+    int status = 0;
+    for (int c = 0; c < dim; ++c) {
+        sp.c[c] = malloc((n > 0 ? n : 1) * (size_t)scalar_size);
+        if (sp.c[c] == NULL) status = -1;
+    }
+    double lo[3] = {DBL_MAX, DBL_MAX, DBL_MAX}, hi[3] = {-DBL_MAX, -DBL_MAX, -DBL_MAX};
+    for (int p = 0; p < n && status == 0; ++p) {
+        const char* point = (const char*)data + (size_t)p * dim * scalar_size;
+        for (int c = 0; c < dim; ++c) {
+            memcpy((char*)sp.c[c] + (size_t)p * scalar_size, point + c * scalar_size, scalar_size);
+            double v;
+            if (scalar_size == sizeof(float)) {
+                float f;
+                memcpy(&f, point + c * scalar_size, sizeof(f));
+                v = f;
+            } else {
+                memcpy(&v, point + c * scalar_size, sizeof(v));
+            }
+            if (v < lo[c]) lo[c] = v;
+            if (v > hi[c]) hi[c] = v;
+        }
+    }
+    if (objective == MAXTRI_MIN_AREA && n > 0) {
+        double d2 = 0.0;
+        for (int c = 0; c < dim; ++c) d2 += (hi[c] - lo[c]) * (hi[c] - lo[c]);
+        // Площадь eps · D² в единицах цели: |det| в 2D, квадрат нормы векторного произведения в 3D
+        double limit = 2.0 * (scalar_size == sizeof(float) ? SPEC_EPS_FLOAT : SPEC_EPS_DOUBLE) * d2;
+        sp.cutoff = dim == 3 ? limit * limit : limit;
+    }
+
+    double huge = scalar_size == sizeof(float) ? FLT_MAX : DBL_MAX;
+    SpecBest best = {objective == MAXTRI_MAX_AREA ? 0.0 : (objective == MAXTRI_MAX_PERIMETER ? -1.0 : huge),
+                     -1, -1, -1};
+    Chunk* chunks = NULL;
+    int chunk_count = 0;
+    SpecTask* tasks = NULL;
+    if (status == 0 && (pool == NULL || threads <= 1)) {
+        for (int i = 0; i < n - 2; ++i) {
+            Chunk row = {i, i + 1, n - 1};
+            scan(&sp, &row, &best);
+        }
+    } else if (status == 0) {
+        // Как в engine_run: по несколько десятков кусков на поток из общей очереди
+        chunk_count = schedule_build(n, threads * 64LL, &chunks);
+        tasks = calloc(threads, sizeof(SpecTask));
+        if (tasks == NULL || chunks == NULL) {
+            status = -1;
+        } else {
+            atomic_int next_chunk;
+            atomic_init(&next_chunk, 0);
+            TaskGroup group = {0};
+            for (int t = 0; t < threads; ++t) {
+                tasks[t] = (SpecTask){&sp, scan, chunks, chunk_count, &next_chunk, best};
+                pool_submit(pool, &group, SpecWorker, &tasks[t]);
+            }
+            pool_wait(pool, &group);
+            for (int t = 0; t < threads; ++t) {
+                spec_merge(&best, &tasks[t].best, objective);
+            }
+        }
+    }
+
+    if (status == 0 && best.i >= 0) {
+        out->value = objective == MAXTRI_MAX_PERIMETER ? best.value
+                   : (dim == 3 ? 0.5 * sqrt(best.value) : 0.5 * best.value);
+        out->i = best.i;
+        out->j = best.j;
+        out->k = best.k;
+    }
+    free(tasks);
+    free(chunks);
+    for (int c = 0; c < dim; ++c) {
+        free(sp.c[c]);
+    }
+    return status;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "pool.h"
+
+// Перебор всех троек, собранный отдельно для каждой размерности (2, 3), типа координат
+// (float, double) и цели (maxtri_objective). Тело перебора (spec_impl.h) включается в spec.c
+// по разу на сочетание, поэтому формула цели встраивается во внутренний цикл без ветвлений,
+// и компилятор векторизует его сам. Сочетание выбирается один раз на вызов.
+
+typedef struct {
+    double value;   // площадь (для наименьшей — тоже площадь) или периметр
+    int i, j, k;    // номера точек по возрастанию; -1 — треугольник не найден
+} SpecResult;
+
+// Треугольник ненулевой площади для MAXTRI_MIN_AREA: площадь больше SPEC_EPS_* · D², где D —
+// диагональ рамки точек. Порог с запасом перекрывает ошибку округления площади в этом типе.
+#define SPEC_EPS_FLOAT 1e-5
+#define SPEC_EPS_DOUBLE 1e-12
+
+// Перебор n точек data (по dim координат размера scalar_size подряд). При threads > 1 куски
+// раздаются задачам пула. Из равных по цели выбираются меньшие номера. Возвращает 0 или -1,
+// если сочетание не поддерживается или не хватило памяти.
+int spec_find(const void* data, int n, int dim, int scalar_size, int objective,
+              ThreadPool* pool, int threads, SpecResult* out);
@@ -0,0 +1,118 @@
+// Тело перебора для одного сочетания. Перед включением определяются SPEC_NAME (суффикс имён),
+// SPEC_DIM (2 или 3), SPEC_T (float или double) и SPEC_OBJECTIVE (SPEC_MAX_AREA,
+// SPEC_MAX_PERIMETER или SPEC_MIN_AREA).
+// Включается только из spec.c, без защиты от повторного включения.
+
+// Вырожденные треугольники получают наибольшее число типа и никогда не оказываются лучше
+#define SPEC_HUGE ((SPEC_T)(sizeof(SPEC_T) == sizeof(float) ? FLT_MAX : DBL_MAX))
+
+#if SPEC_OBJECTIVE == SPEC_MIN_AREA
+#define SPEC_BETTER(a, b) ((a) < (b))
+#else
+#define SPEC_BETTER(a, b) ((a) > (b))
+#endif
+
+// Значения цели для k из [k_begin, k_end) при фиксированных i и j: сначала блок значений
+// без ветвлений, затем лучшее значение блока свёрткой, и только если оно лучше *best — его k.
+// Если лучшее значение строго лучше *best, оно записывается в *best, а его k (наименьший
+// при равенстве) — в *best_k.
+static inline __attribute__((always_inline)) void SPEC_FN(spec_pair)(const SpecPoints* sp, int i, int j,
+                                                                     int k_begin, int k_end,
+                                                                     SPEC_T* best, int* best_k) {
+    const SPEC_T* restrict x = (const SPEC_T*)sp->c[0];
+    const SPEC_T* restrict y = (const SPEC_T*)sp->c[1];
+#if SPEC_DIM == 3
+    const SPEC_T* restrict z = (const SPEC_T*)sp->c[2];
+#endif
+    SPEC_T ax = x[j] - x[i];
+    SPEC_T ay = y[j] - y[i];
+#if SPEC_DIM == 3
+    SPEC_T az = z[j] - z[i];
+#endif
+#if SPEC_OBJECTIVE == SPEC_MAX_PERIMETER
+#if SPEC_DIM == 3
+    SPEC_T side = sqrt(ax * ax + ay * ay + az * az);
+#else
+    SPEC_T side = sqrt(ax * ax + ay * ay);
+#endif
+#elif SPEC_OBJECTIVE == SPEC_MIN_AREA
+    SPEC_T cutoff = (SPEC_T)sp->cutoff;
+#endif
+    SPEC_T values[SPEC_BLOCK];
+    SPEC_T local = *best;
+    int local_k = -1;
+    for (int kb = k_begin; kb < k_end; kb += SPEC_BLOCK) {
+        int len = k_end - kb < SPEC_BLOCK ? k_end - kb : SPEC_BLOCK;
+        for (int t = 0; t < len; ++t) {
+            int k = kb + t;
+            SPEC_T bx = x[k] - x[i];
+            SPEC_T by = y[k] - y[i];
+#if SPEC_DIM == 3
+            SPEC_T bz = z[k] - z[i];
+#endif
+#if SPEC_OBJECTIVE == SPEC_MAX_PERIMETER
+            SPEC_T dx = x[k] - x[j];
+            SPEC_T dy = y[k] - y[j];
+#if SPEC_DIM == 3
+            SPEC_T dz = z[k] - z[j];
+            values[t] = side + sqrt(bx * bx + by * by + bz * bz) + sqrt(dx * dx + dy * dy + dz * dz);
+#else
+            values[t] = side + sqrt(bx * bx + by * by) + sqrt(dx * dx + dy * dy);
+#endif
+#else
+            // В 3D — квадрат нормы векторного произведения, как в kernel.c, в 2D — модуль определителя
+#if SPEC_DIM == 3
+            SPEC_T cx = ay * bz - az * by;
+            SPEC_T cy = az * bx - ax * bz;
+            SPEC_T cz = ax * by - ay * bx;
+            SPEC_T v = cx * cx + cy * cy + cz * cz;
+#else
+            SPEC_T v = fabs(ax * by - ay * bx);
+#endif
+#if SPEC_OBJECTIVE == SPEC_MIN_AREA
+            values[t] = v > cutoff ? v : SPEC_HUGE;
+#else
+            values[t] = v;
+#endif
+#endif
+        }
+        SPEC_T m = values[0];
+        for (int t = 1; t < len; ++t) {
+            m = SPEC_BETTER(values[t], m) ? values[t] : m;
+        }
+        if (SPEC_BETTER(m, local)) {
+            int t = 0;
+            while (t < len && values[t] != m) ++t;
+            if (t < len) {
+                local = m;
+                local_k = kb + t;
+            }
+        }
+    }
+    if (local_k >= 0) {
+        *best = local;
+        *best_k = local_k;
+    }
+}
+
+// Перебор куска по порядку (i, j, k): из равных остаётся первый, то есть с меньшими номерами
+SPEC_CLONES static void SPEC_FN(spec_chunk)(const SpecPoints* sp, const Chunk* chunk, SpecBest* best) {
+    SPEC_T value = (SPEC_T)best->value;
+    for (int j = chunk->j_begin; j < chunk->j_end; ++j) {
+        int k = -1;
+        SPEC_FN(spec_pair)(sp, chunk->i, j, j + 1, sp->n, &value, &k);
+        if (k >= 0) {
+            best->value = value;
+            best->i = chunk->i;
+            best->j = j;
+            best->k = k;
+        }
+    }
+}
+
+#undef SPEC_HUGE
+#undef SPEC_BETTER
+#undef SPEC_NAME
+#undef SPEC_DIM
+#undef SPEC_T
+#undef SPEC_OBJECTIVE
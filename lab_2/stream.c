@@ -0,0 +1,259 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "stream.h"
+#include "hull.h"
+#include "loader.h"
+
+// Пауза перед новой попыткой прочитать дописанный конец файла
+#define STREAM_POLL_MS 200
+
+int stream_init(Stream* stream, const maxtri_opts* opts) {
+    memset(stream, 0, sizeof(Stream));
+    stream->best = (Triangle){0.0f, -1, -1, -1};
+    stream->config.row_kernel = kernel_get(opts->kernel);
+    stream->config.norm_kernel = kernel_norms_get(opts->kernel);
+    if (stream->config.row_kernel == NULL || stream->config.norm_kernel == NULL) {
+        return MAXTRI_EKERNEL;
+    }
+    kernel_tile_sizes(&stream->config.tile_j, &stream->config.tile_k);
+    if (opts->tile >= 0) {
+        stream->config.tile_k = opts->tile;
+    }
+    stream->config.prune = opts->prune;
+    stream->config.top_k = 1;
+    stream->pool = opts->pool;
+    stream->threads = opts->pool ? pool_workers(opts->pool) : 1;
+    return MAXTRI_OK;
+}
+
+void stream_free(Stream* stream) {
+    free(stream->xyz);
+    free(stream->ids);
+    memset(stream, 0, sizeof(Stream));
+}
+
+maxtri_triangle stream_best(const Stream* stream) {
+    maxtri_triangle t = {0.0, -1, -1, -1};
+    if (stream->best.i >= 0) {
+        t.area = 0.5 * sqrt(stream->best.cross2);
+        t.i = stream->best.i;
+        t.j = stream->best.j;
+        t.k = stream->best.k;
+    }
+    return t;
+}
+
+int stream_append(Stream* stream, const float (*xyz)[3], int count) {
+    if (count <= 0) {
+        return MAXTRI_OK;
+    }
+    int old_count = stream->hull_count;
+    int m = old_count + count;
+    if (m > stream->cap) {
+        int cap = stream->cap ? stream->cap : 1024;
+        while (cap < m) cap *= 2;
+        float (*grown)[3] = realloc(stream->xyz, cap * sizeof(*grown));
+        int* ids = realloc(stream->ids, cap * sizeof(int));
+        if (grown != NULL) stream->xyz = grown;
+        if (ids != NULL) stream->ids = ids;
+        if (grown == NULL || ids == NULL) {
+            return MAXTRI_ENOMEM;
+        }
+        stream->cap = cap;
+    }
+
+    // Оболочка всех точек — оболочка прежних вершин и новых точек. Новые точки дописываются
+    // за вершинами, их номера в потоке больше прежних, поэтому номера идут по возрастанию.
+    int* local = malloc(m * sizeof(int));
+    int* hull = malloc(m * sizeof(int));
+    if (local == NULL || hull == NULL) {
+        free(local);
+        free(hull);
+        return MAXTRI_ENOMEM;
+    }
+    memcpy(stream->xyz[old_count], xyz, count * sizeof(*stream->xyz));
+    for (int p = 0; p < count; ++p) {
+        stream->ids[old_count + p] = stream->n + p;
+    }
+    for (int p = 0; p < m; ++p) {
+        local[p] = p;
+    }
+    stream->n += count;
+    int hull_count = hull_vertices((const float (*)[3])stream->xyz, local, m, hull);
+    // Остаются только вершины новой оболочки; hull[t] >= t, поэтому сжатие на месте ничего не затирает
+    int fresh = 0;
+    for (int t = 0; t < hull_count; ++t) {
+        fresh += hull[t] < old_count;
+        memcpy(stream->xyz[t], stream->xyz[hull[t]], sizeof(*stream->xyz));
+        stream->ids[t] = stream->ids[hull[t]];
+    }
+    stream->hull_count = hull_count;
+    free(local);
+    free(hull);
+    if (hull_count < 3 || fresh == hull_count) {
+        return MAXTRI_OK;
+    }
+
+    // Порядок вершин в переборе совпадает с порядком номеров, поэтому среди равных по площади
+    // выбираются те же номера, что и при переборе всех троек оболочки
+    Engine engine;
+    Scan scan;
+    if (engine_init(&engine, (const float (*)[3])stream->xyz, NULL, hull_count, &stream->config) != 0) {
+        return MAXTRI_ENOMEM;
+    }
+    engine.fresh = fresh;
+    if (stream->best.i >= 0 && stream->config.prune) {
+        engine_raise_bound(&engine, stream->best.cross2);
+    }
+    int status = MAXTRI_OK;
+    if (scan_init(&scan, &engine) != 0) {
+        status = MAXTRI_ENOMEM;
+    } else {
+        if (engine_run(&engine, stream->pool, stream->threads, &scan) != 0) {
+            status = MAXTRI_ENOMEM;
+        } else if (scan.i >= 0) {
+            Triangle found = {scan.best, stream->ids[scan.i], stream->ids[scan.j], stream->ids[scan.k]};
+            if (stream->best.i < 0 || triangle_better(&found, &stream->best)) {
+                stream->best = found;
+            }
+        }
+        scan_free(&scan);
+    }
+    engine_free(&engine);
+    return status;
+}
+
+static long long elapsed_ms(const struct timespec* start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) * 1000LL + (end.tv_nsec - start->tv_nsec) / 1000000LL;
+}
+
+static int stream_batch(Stream* stream, const float (*xyz)[3], int count, int batch) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int status = stream_append(stream, xyz, count);
+    if (status != MAXTRI_OK) {
+        return status;
+    }
+    printf("Batch %d: %d new points, %d total, %d hull vertices, %lld ms\n",
+           batch, count, stream->n, stream->hull_count, elapsed_ms(&start));
+    maxtri_triangle best = stream_best(stream);
+    if (best.i >= 0) {
+        printf("Max area: %.2f at points %d, %d, %d\n", best.area, best.i, best.j, best.k);
+    }
+    // Ответ нужен читающему сразу, даже если вывод идёт в канал
+    fflush(stdout);
+    return MAXTRI_OK;
+}
+
+int stream_run(const char* path, const float (*xyz)[3], int n, const maxtri_opts* opts) {
+    Stream stream;
+    int status = stream_init(&stream, opts);
+    if (status != MAXTRI_OK) {
+        return status;
+    }
+    int follow = strcmp(path, "-") != 0;
+    int fd = follow ? open(path, O_RDONLY) : STDIN_FILENO;
+    if (fd < 0) {
+        printf("Failed to open %s\n", path);
+        stream_free(&stream);
+        return MAXTRI_EINVAL;
+    }
+    int batch = 0;
+    if (n > 0) {
+        status = stream_batch(&stream, xyz, n, ++batch);
+    }
+
+    size_t cap = 1 << 16, len = 0;
+    char* buf = malloc(cap);
+    int points_cap = 1024, points_count = 0;
+    float (*points)[3] = malloc(points_cap * sizeof(*points));
+    if (buf == NULL || points == NULL) {
+        status = MAXTRI_ENOMEM;
+    }
+    long long line = 0;
+    while (status == MAXTRI_OK) {
+        if (len == cap) {
+            char* grown = realloc(buf, cap * 2);
+            if (grown == NULL) {
+                status = MAXTRI_ENOMEM;
+                break;
+            }
+            buf = grown;
+            cap *= 2;
+        }
+        ssize_t got = read(fd, buf + len, cap - len);
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) {
+            printf("Failed to read %s\n", path);
+            status = MAXTRI_EINVAL;
+            break;
+        }
+        len += got;
+        // Разбираются только законченные строки, кроме последней строки стандартного ввода
+        char* begin = buf;
+        char* end = buf + len;
+        for (;;) {
+            char* eol = memchr(begin, '\n', end - begin);
+            if (eol == NULL) {
+                if (got > 0 || follow || begin == end) break;
+                eol = end;
+            }
+            float point[3];
+            ++line;
+            int parsed = points_parse_line(begin, eol, point);
+            if (parsed < 0) {
+                printf("Line %lld: invalid point, skipped\n", line);
+            } else if (parsed > 0) {
+                if (points_count == points_cap) {
+                    float (*grown)[3] = realloc(points, points_cap * 2 * sizeof(*points));
+                    if (grown == NULL) {
+                        status = MAXTRI_ENOMEM;
+                        break;
+                    }
+                    points = grown;
+                    points_cap *= 2;
+                }
+                memcpy(points[points_count++], point, sizeof(point));
+            }
+            begin = eol < end ? eol + 1 : end;
+        }
+        if (status != MAXTRI_OK) {
+            break;
+        }
+        len = end - begin;
+        memmove(buf, begin, len);
+
+        // Порция кончается, когда новых данных пока нет
+        struct pollfd pfd = {fd, POLLIN, 0};
+        if (got > 0 && poll(&pfd, 1, 0) > 0) {
+            continue;
+        }
+        if (points_count > 0) {
+            status = stream_batch(&stream, (const float (*)[3])points, points_count, ++batch);
+            points_count = 0;
+        }
+        if (got == 0) {
+            if (!follow) break;
+            struct timespec pause = {0, STREAM_POLL_MS * 1000000L};
+            nanosleep(&pause, NULL);
+        }
+    }
+    free(points);
+    free(buf);
+    if (follow) {
+        close(fd);
+    }
+    stream_free(&stream);
+    return status;
+}
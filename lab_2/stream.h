@@ -0,0 +1,36 @@
+#pragma once
+
+#include "maxtri.h"
+#include "engine.h"
+
+// Поддержка ответа при дописывании точек. Треугольник максимальной площади опирается на вершины
+// выпуклой оболочки, поэтому хранятся только вершины оболочки всех точек и их номера в потоке,
+// а память не растёт с длиной потока. Новый треугольник может обогнать прежний ответ, только если
+// в нём есть новая точка, так что после каждой порции перебираются лишь тройки вершин новой
+// оболочки хотя бы с одной новой вершиной.
+typedef struct {
+    EngineConfig config;
+    ThreadPool* pool;
+    int threads;
+    float (*xyz)[3];    // вершины оболочки; при добавлении за ними временно лежат новые точки
+    int* ids;           // номера этих точек в потоке по возрастанию
+    int hull_count, cap;
+    int n;              // всего точек в потоке
+    Triangle best;      // квадрат и номера точек; i == -1 — треугольника ещё нет
+} Stream;
+
+// Пустой набор точек с настройками перебора из opts (ядро, блоки, отсечение, пул)
+int stream_init(Stream* stream, const maxtri_opts* opts);
+void stream_free(Stream* stream);
+
+// Дописывает count точек и обновляет ответ. Возвращает MAXTRI_OK или код ошибки.
+int stream_append(Stream* stream, const float (*xyz)[3], int count);
+
+// Ответ в виде площади
+maxtri_triangle stream_best(const Stream* stream);
+
+// Читает точки текстового формата из path ("-" — стандартный ввод) порциями: порция — всё,
+// что успело прийти к моменту чтения. Начальные точки xyz[0..n-1] считаются первой порцией.
+// После каждой порции печатает ответ. Файл читается с конца, как tail -f, до прерывания,
+// стандартный ввод — до конца ввода.
+int stream_run(const char* path, const float (*xyz)[3], int n, const maxtri_opts* opts);
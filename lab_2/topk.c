@@ -0,0 +1,63 @@
+#include <stdlib.h>
+#include "topk.h"
+
+int topk_init(TopK* top, int cap) {
+    top->items = malloc(cap * sizeof(Triangle));
+    top->count = 0;
+    top->cap = cap;
+    return top->items ? 0 : -1;
+}
+
+void topk_free(TopK* top) {
+    free(top->items);
+    top->items = NULL;
+    top->count = top->cap = 0;
+}
+
+static void sift_down(TopK* top, int p) {
+    Triangle* h = top->items;
+    while (1) {
+        int worst = p;
+        int l = 2 * p + 1, r = 2 * p + 2;
+        if (l < top->count && triangle_better(&h[worst], &h[l])) worst = l;
+        if (r < top->count && triangle_better(&h[worst], &h[r])) worst = r;
+        if (worst == p) {
+            return;
+        }
+        Triangle t = h[p];
+        h[p] = h[worst];
+        h[worst] = t;
+        p = worst;
+    }
+}
+
+void topk_push(TopK* top, const Triangle* t) {
+    Triangle* h = top->items;
+    if (top->count < top->cap) {
+        int p = top->count++;
+        while (p > 0 && triangle_better(&h[(p - 1) / 2], t)) {
+            h[p] = h[(p - 1) / 2];
+            p = (p - 1) / 2;
+        }
+        h[p] = *t;
+    } else if (top->cap > 0 && triangle_better(t, &h[0])) {
+        h[0] = *t;
+        sift_down(top, 0);
+    }
+}
+
+void topk_merge(TopK* top, const TopK* from) {
+    for (int t = 0; t < from->count; ++t) {
+        topk_push(top, &from->items[t]);
+    }
+}
+
+static int cmp_better(const void* a, const void* b) {
+    if (triangle_better(a, b)) return -1;
+    if (triangle_better(b, a)) return 1;
+    return 0;
+}
+
+void topk_sort(TopK* top) {
+    qsort(top->items, top->count, sizeof(Triangle), cmp_better);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+// Треугольник перебора: квадрат нормы векторного произведения и номера вершин i < j < k
+typedef struct {
+    float cross2;
+    int i, j, k;
+} Triangle;
+
+// Ограниченная куча из cap лучших треугольников; в корне худший из них
+typedef struct {
+    Triangle* items;
+    int count, cap;
+} TopK;
+
+// Лучше ли a, чем b: большая площадь, при равенстве — меньшие номера точек
+static inline int triangle_better(const Triangle* a, const Triangle* b) {
+    if (a->cross2 != b->cross2) return a->cross2 > b->cross2;
+    if (a->i != b->i) return a->i < b->i;
+    if (a->j != b->j) return a->j < b->j;
+    return a->k < b->k;
+}
+
+// Квадрат, который нужно превзойти или повторить, чтобы попасть в кучу; -1 — куча не заполнена
+static inline float topk_threshold(const TopK* top) {
+    return top->count < top->cap ? -1.0f : top->items[0].cross2;
+}
+
+int topk_init(TopK* top, int cap);
+void topk_free(TopK* top);
+
+// Добавляет треугольник, если куча не заполнена или он лучше худшего в ней
+void topk_push(TopK* top, const Triangle* t);
+
+// Переносит все треугольники из from в top
+void topk_merge(TopK* top, const TopK* from);
+
+// Упорядочивает треугольники от лучшего к худшему; после этого куча больше не используется
+void topk_sort(TopK* top);